@@ -0,0 +1,334 @@
+#include "Convolution.h"
+#include "ConvolutionSIMD.h"
+#include "PGMImage.h"
+#include "PPMImage.h"
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+// Kernels de los filtros incluidos
+static const double BLUR_WEIGHTS[3][3] = {
+    {1.0/9.0, 1.0/9.0, 1.0/9.0},
+    {1.0/9.0, 1.0/9.0, 1.0/9.0},
+    {1.0/9.0, 1.0/9.0, 1.0/9.0}
+};
+
+static const double LAPLACIAN_WEIGHTS[3][3] = {
+    { 0, -1,  0},
+    {-1,  4, -1},
+    { 0, -1,  0}
+};
+
+static const double SHARPEN_WEIGHTS[3][3] = {
+    { 0, -1,  0},
+    {-1,  5, -1},
+    { 0, -1,  0}
+};
+
+bool getFilterKernel(const char* filterName, Kernel3x3& kernel) {
+    if (strcmp(filterName, "Blur") == 0) {
+        memcpy(kernel.weights, BLUR_WEIGHTS, sizeof(kernel.weights));
+        kernel.offset = 0;
+    } else if (strcmp(filterName, "Laplacian") == 0) {
+        memcpy(kernel.weights, LAPLACIAN_WEIGHTS, sizeof(kernel.weights));
+        kernel.offset = 128;
+    } else if (strcmp(filterName, "Sharpen") == 0) {
+        memcpy(kernel.weights, SHARPEN_WEIGHTS, sizeof(kernel.weights));
+        kernel.offset = 0;
+    } else {
+        return false;
+    }
+    prepareKernel(kernel);
+    return true;
+}
+
+// Mayor divisor que se intenta al buscar la forma entera del kernel
+static const int MAX_KERNEL_DIVISOR = 255;
+
+void prepareKernel(Kernel3x3& kernel) {
+    kernel.integer = false;
+    kernel.divisor = 1;
+    kernel.nonNegative = false;
+    kernel.weightMagnitude = 0;
+    kernel.taps = 0;
+    kernel.reciprocal16 = 0;
+    kernel.reciprocalLimit = -1;
+    
+    for (int d = 1; d <= MAX_KERNEL_DIVISOR && !kernel.integer; d += 2) {
+        bool exact = true;
+        bool nonNegative = true;
+        long magnitude = 0;
+        for (int ky = 0; ky < 3 && exact; ky++) {
+            for (int kx = 0; kx < 3 && exact; kx++) {
+                double scaled = kernel.weights[ky][kx] * d;
+                long rounded = std::lround(scaled);
+                exact = std::fabs(scaled - rounded) < 1e-9;
+                kernel.intWeights[ky][kx] = (int)rounded;
+                nonNegative = nonNegative && rounded >= 0;
+                magnitude += std::labs(rounded);
+            }
+        }
+        
+        // 2 * suma + divisor debe caber en un int con muestras de 16 bits
+        if (exact && magnitude * 65535L < (1L << 30)) {
+            kernel.integer = true;
+            kernel.divisor = d;
+            kernel.nonNegative = nonNegative;
+            kernel.weightMagnitude = (int)magnitude;
+        }
+    }
+    if (!kernel.integer) return;
+    
+    for (int ky = 0; ky < 3; ky++) {
+        for (int kx = 0; kx < 3; kx++) {
+            if (kernel.intWeights[ky][kx] != 0) {
+                kernel.tapRow[kernel.taps] = ky;
+                kernel.tapColumn[kernel.taps] = kx - 1;
+                kernel.tapWeight[kernel.taps] = kernel.intWeights[ky][kx];
+                kernel.taps++;
+            }
+        }
+    }
+    
+    // Mayor numerador (hasta 32767) para el que el recíproco redondeado hacia
+    // arriba da el cociente exacto
+    if (kernel.divisor > 1) {
+        int reciprocal = (65536 + kernel.divisor - 1) / kernel.divisor;
+        int limit = 0;
+        while (limit < 32767 && ((limit + 1) * reciprocal >> 16) == (limit + 1) / kernel.divisor) {
+            limit++;
+        }
+        kernel.reciprocal16 = reciprocal;
+        kernel.reciprocalLimit = limit;
+    }
+}
+
+// Redondeo de suma / divisor. Con divisor impar no hay empates, así que
+// floor(suma / divisor + 1/2) coincide con std::round sobre la suma en double
+struct RoundExact {
+    int operator()(int sum) const { return sum; }
+};
+
+// Divisor 9 con suma no negativa: (suma + 4) / 9 como multiplicación y
+// desplazamiento (exacto para sumas menores que 2^20, 9 * 65535 + 4 incluido)
+struct RoundDivide9 {
+    int operator()(int sum) const {
+        return (int)(((uint64_t)(uint32_t)(sum + 4) * 1864136u) >> 24);
+    }
+};
+
+struct RoundDivide {
+    int divisor;
+    int operator()(int sum) const {
+        int numerator = 2 * sum + divisor;
+        int denominator = 2 * divisor;
+        int quotient = numerator / denominator;
+        if (numerator % denominator != 0 && numerator < 0) quotient--;
+        return quotient;
+    }
+};
+
+// Cálculo de una muestra con aritmética entera a partir de los índices de la
+// columna izquierda, central y derecha. Los pesos se copian al muestreador:
+// leídos desde el kernel habría que recargarlos tras cada escritura en la
+// salida (uint8_t puede ser alias de cualquier tipo)
+template <typename T, typename Round>
+struct IntegerSampler {
+    int w[3][3];
+    int offset;
+    int maxVal;
+    Round round;
+    
+    IntegerSampler(const Kernel3x3& kernel, int max, Round rounding) : offset(kernel.offset), maxVal(max), round(rounding) {
+        memcpy(w, kernel.intWeights, sizeof(w));
+    }
+    
+    T operator()(const T* r0, const T* r1, const T* r2, size_t left, size_t center, size_t right) const {
+        int sum = r0[left] * w[0][0] + r0[center] * w[0][1] + r0[right] * w[0][2]
+                + r1[left] * w[1][0] + r1[center] * w[1][1] + r1[right] * w[1][2]
+                + r2[left] * w[2][0] + r2[center] * w[2][1] + r2[right] * w[2][2];
+        int result = round(sum) + offset;
+        result = result < 0 ? 0 : result;
+        result = result > maxVal ? maxVal : result;
+        return (T)result;
+    }
+};
+
+// Cálculo en double para kernels sin forma entera. Mismo orden de acumulación
+// que la versión original con getPixel/setPixel
+template <typename T>
+struct DoubleSampler {
+    double w[3][3];
+    int offset;
+    int maxVal;
+    
+    DoubleSampler(const Kernel3x3& kernel, int max) : offset(kernel.offset), maxVal(max) {
+        memcpy(w, kernel.weights, sizeof(w));
+    }
+    
+    T operator()(const T* r0, const T* r1, const T* r2, size_t left, size_t center, size_t right) const {
+        double sum = 0;
+        sum += r0[left] * w[0][0];
+        sum += r0[center] * w[0][1];
+        sum += r0[right] * w[0][2];
+        sum += r1[left] * w[1][0];
+        sum += r1[center] * w[1][1];
+        sum += r1[right] * w[1][2];
+        sum += r2[left] * w[2][0];
+        sum += r2[center] * w[2][1];
+        sum += r2[right] * w[2][2];
+        int result = (int)std::round(sum) + offset;
+        result = result < 0 ? 0 : result;
+        result = result > maxVal ? maxVal : result;
+        return (T)result;
+    }
+};
+
+// Recorre las columnas [startX, endX). Solo las columnas 0 y width - 1
+// replican el borde; el interior usa las vecinas a +-channels muestras sin
+// comprobar límites, en un único bucle sobre muestras que el compilador
+// puede desenrollar
+template <typename T, typename Sampler>
+static void convolveSpanWith(const T* const rows[3], T* out, int width, int channels,
+                             int startX, int endX, const Sampler& sampler) {
+    const T* r0 = rows[0];
+    const T* r1 = rows[1];
+    const T* r2 = rows[2];
+    const size_t step = (size_t)channels;
+    
+    // Borde izquierdo
+    if (startX == 0 && endX > 0) {
+        size_t right = width > 1 ? step : 0;
+        for (size_t c = 0; c < step; c++) {
+            out[c] = sampler(r0, r1, r2, c, c, right + c);
+        }
+    }
+    
+    // Interior
+    int innerStart = startX > 1 ? startX : 1;
+    int innerEnd = endX < width - 1 ? endX : width - 1;
+    if (innerStart < innerEnd) {
+        const size_t first = (size_t)innerStart * step;
+        const size_t last = (size_t)innerEnd * step;
+        for (size_t i = first; i < last; i++) {
+            out[i] = sampler(r0, r1, r2, i - step, i, i + step);
+        }
+    }
+    
+    // Borde derecho
+    if (width > 1 && endX == width && startX < endX) {
+        size_t center = (size_t)(width - 1) * step;
+        for (size_t c = 0; c < step; c++) {
+            out[center + c] = sampler(r0, r1, r2, center - step + c, center + c, center + c);
+        }
+    }
+}
+
+// Elige la aritmética según la forma del kernel
+template <typename T>
+static void convolveSpanScalar(const T* const rows[3], T* out, int width, int channels,
+                               int startX, int endX, const Kernel3x3& kernel, int maxVal) {
+    if (!kernel.integer) {
+        convolveSpanWith(rows, out, width, channels, startX, endX, DoubleSampler<T>(kernel, maxVal));
+    } else if (kernel.divisor == 1) {
+        convolveSpanWith(rows, out, width, channels, startX, endX,
+                         IntegerSampler<T, RoundExact>(kernel, maxVal, RoundExact()));
+    } else if (kernel.divisor == 9 && kernel.nonNegative) {
+        convolveSpanWith(rows, out, width, channels, startX, endX,
+                         IntegerSampler<T, RoundDivide9>(kernel, maxVal, RoundDivide9()));
+    } else {
+        RoundDivide round = {kernel.divisor};
+        convolveSpanWith(rows, out, width, channels, startX, endX,
+                         IntegerSampler<T, RoundDivide>(kernel, maxVal, round));
+    }
+}
+
+template <typename T>
+static void convolveSpan(const T* above, const T* current, const T* below, T* out, int width, int channels,
+                         int startX, int endX, const Kernel3x3& kernel, int maxVal) {
+    const T* const rows[3] = {above, current, below};
+    
+    // Columnas interiores (con vecinas a ambos lados) con instrucciones
+    // vectoriales; los bordes y el resto quedan para la versión escalar
+    int innerStart = startX > 1 ? startX : 1;
+    int innerEnd = endX < width - 1 ? endX : width - 1;
+    if (kernel.integer && innerStart < innerEnd) {
+        size_t done = convolveSamplesSIMD(rows, out, (size_t)innerStart * channels,
+                                          (size_t)innerEnd * channels, channels, kernel, maxVal);
+        int doneX = (int)(done / channels);
+        if (doneX > innerStart) {
+            convolveSpanScalar(rows, out, width, channels, startX, innerStart, kernel, maxVal);
+            startX = doneX;
+        }
+    }
+    convolveSpanScalar(rows, out, width, channels, startX, endX, kernel, maxVal);
+}
+
+void convolveRow(const uint8_t* above, const uint8_t* current, const uint8_t* below,
+                 uint8_t* out, int width, int channels, const Kernel3x3& kernel, int maxVal) {
+    convolveSpan(above, current, below, out, width, channels, 0, width, kernel, maxVal);
+}
+
+void convolveRow(const uint16_t* above, const uint16_t* current, const uint16_t* below,
+                 uint16_t* out, int width, int channels, const Kernel3x3& kernel, int maxVal) {
+    convolveSpan(above, current, below, out, width, channels, 0, width, kernel, maxVal);
+}
+
+template <typename T, typename ImageType>
+static void convolveImageRegion(const ImageType* input, ImageType* output, int channels, const Kernel3x3& kernel,
+                                int startX, int endX, int startY, int endY) {
+    int width = input->getWidth();
+    int height = input->getHeight();
+    int maxVal = input->getMaxVal();
+    
+    // La región que llega a la última columna también pone a cero el relleno
+    // de alineación de sus filas: así las salidas creadas sin inicializar
+    // (first-touch) quedan completas sin que otro hilo toque sus páginas
+    size_t samples = (size_t)width * channels;
+    size_t padding = endX >= width ? (size_t)output->getStride() - samples * sizeof(T) : 0;
+    
+    for (int y = startY; y < endY; y++) {
+        // Filas vecinas replicando los bordes superior e inferior
+        const T* above = input->template row<T>(y > 0 ? y - 1 : 0).data();
+        const T* current = input->template row<T>(y).data();
+        const T* below = input->template row<T>(y + 1 < height ? y + 1 : height - 1).data();
+        T* out = output->template row<T>(y).data();
+        convolveSpan(above, current, below, out, width, channels, startX, endX, kernel, maxVal);
+        if (padding > 0) memset(out + samples, 0, padding);
+    }
+}
+
+// Bytes de un píxel en memoria (todas sus muestras)
+static size_t pixelBytes(const Image* image) {
+    int channels = dynamic_cast<const PPMImage*>(image) ? 3 : 1;
+    return (size_t)image->getSampleSize() * channels;
+}
+
+int defaultTileSize(const Image* image) {
+    // Lado tal que 2 * lado^2 * bytesPorPíxel <= TILE_CACHE_BYTES
+    int size = (int)std::sqrt((double)TILE_CACHE_BYTES / (2 * pixelBytes(image)));
+    return std::max(16, size / 16 * 16);
+}
+
+int defaultBandRows(const Image* image) {
+    size_t rowBytes = 2 * pixelBytes(image) * (size_t)std::max(1, image->getWidth());
+    return (int)std::max((size_t)1, TILE_CACHE_BYTES / rowBytes);
+}
+
+void convolveRegion(const Image* input, Image* output, const Kernel3x3& kernel,
+                    int startX, int endX, int startY, int endY) {
+    const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
+    const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
+    PGMImage* pgmOutput = dynamic_cast<PGMImage*>(output);
+    PPMImage* ppmOutput = dynamic_cast<PPMImage*>(output);
+    bool wide = input->getSampleSize() == 2;
+    
+    if (pgmInput && pgmOutput) {
+        if (wide) convolveImageRegion<uint16_t>(pgmInput, pgmOutput, 1, kernel, startX, endX, startY, endY);
+        else convolveImageRegion<uint8_t>(pgmInput, pgmOutput, 1, kernel, startX, endX, startY, endY);
+    } else if (ppmInput && ppmOutput) {
+        if (wide) convolveImageRegion<uint16_t>(ppmInput, ppmOutput, 3, kernel, startX, endX, startY, endY);
+        else convolveImageRegion<uint8_t>(ppmInput, ppmOutput, 3, kernel, startX, endX, startY, endY);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <cstdint>
+#include <cstddef>
+
+class Image;
+
+// Kernel 3x3 de un filtro y desplazamiento que se suma al resultado redondeado
+struct Kernel3x3 {
+    double weights[3][3];
+    int offset;   // 128 en el Laplaciano para centrar el resultado
+    
+    // Forma entera calculada por prepareKernel(): weights = intWeights / divisor.
+    // Si integer es false se usa la aritmética en double
+    bool integer;
+    int intWeights[3][3];
+    int divisor;          // Impar, para que el redondeo nunca tenga empates
+    bool nonNegative;     // Todos los pesos >= 0 (la suma nunca es negativa)
+    int weightMagnitude;  // Suma de |intWeights|: acota la suma de una muestra
+    
+    // Pesos no nulos, para las versiones vectoriales
+    int taps;
+    int tapRow[9];        // 0: fila superior, 1: actual, 2: inferior
+    int tapColumn[9];     // -1, 0 o 1
+    int tapWeight[9];
+    
+    // División con multiplicación alta de 16 bits: n / divisor ==
+    // (n * reciprocal16) >> 16 para todo 0 <= n <= reciprocalLimit
+    int reciprocal16;
+    int reciprocalLimit;
+};
+
+// Kernel asociado al nombre de un filtro (Filter::getName(): "Blur",
+// "Laplacian" o "Sharpen"), ya preparado. Devuelve false si no se reconoce
+bool getFilterKernel(const char* filterName, Kernel3x3& kernel);
+
+// Busca la forma entera del kernel. Se acepta si todos los pesos son enteros
+// divididos por un mismo divisor impar y la suma cabe en un int: el resultado
+// es entonces idéntico al redondeo de la suma en double
+void prepareKernel(Kernel3x3& kernel);
+
+// Convoluciona una fila de 'width' píxeles de 'channels' muestras intercaladas
+// a partir de la fila superior, la actual y la inferior (en los bordes
+// superior e inferior se pasa la fila actual repetida). Las columnas fuera de
+// la imagen replican el borde. Resultado redondeado, con el desplazamiento
+// sumado y saturado a [0, maxVal]
+void convolveRow(const uint8_t* above, const uint8_t* current, const uint8_t* below,
+                 uint8_t* out, int width, int channels, const Kernel3x3& kernel, int maxVal);
+void convolveRow(const uint16_t* above, const uint16_t* current, const uint16_t* below,
+                 uint16_t* out, int width, int channels, const Kernel3x3& kernel, int maxVal);
+
+// Conjunto de instrucciones vectoriales usado por convolveRow/convolveRegion
+// ("AVX2", "SSE4.1" o "escalar"). Se detecta en tiempo de ejecución; la
+// variable de entorno FILTER_SIMD=avx2|sse4|none limita el nivel
+const char* getSIMDLevelName();
+
+// Aplica el kernel a la región [startX, endX) x [startY, endY) de 'input' y la
+// escribe en 'output' (PGM o PPM, mismas dimensiones y maxVal)
+void convolveRegion(const Image* input, Image* output, const Kernel3x3& kernel,
+                    int startX, int endX, int startY, int endY);
+
+// Presupuesto de caché de una tesela (entrada + salida): la mitad de un L2
+// típico de 512 KB, para dejar sitio a las filas vecinas y al resto del hilo
+const size_t TILE_CACHE_BYTES = 256 * 1024;
+
+// Lado de una tesela cuadrada (múltiplo de 16, al menos 16) cuya entrada y
+// salida ocupan como mucho TILE_CACHE_BYTES
+int defaultTileSize(const Image* image);
+
+// Filas de una banda de ancho completo con el mismo presupuesto (al menos 1)
+int defaultBandRows(const Image* image);
+
+#endif // CONVOLUTION_H
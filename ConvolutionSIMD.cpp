@@ -0,0 +1,250 @@
+#include "ConvolutionSIMD.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVOLUTION_X86 1
+#include <immintrin.h>
+#endif
+
+enum SIMDLevel {
+    SIMD_NONE = 0,
+    SIMD_SSE41 = 1,
+    SIMD_AVX2 = 2
+};
+
+// Nivel soportado por la CPU (cpuid), limitado opcionalmente con FILTER_SIMD
+static SIMDLevel detectSIMDLevel() {
+    SIMDLevel level = SIMD_NONE;
+#ifdef CONVOLUTION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        level = SIMD_AVX2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        level = SIMD_SSE41;
+    }
+#endif
+    const char* requested = getenv("FILTER_SIMD");
+    if (requested != nullptr) {
+        if (strcmp(requested, "none") == 0) {
+            level = SIMD_NONE;
+        } else if (strcmp(requested, "sse4") == 0 && level > SIMD_SSE41) {
+            level = SIMD_SSE41;
+        }
+    }
+    return level;
+}
+
+static SIMDLevel getSIMDLevel() {
+    static const SIMDLevel level = detectSIMDLevel();
+    return level;
+}
+
+const char* getSIMDLevelName() {
+    switch (getSIMDLevel()) {
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_SSE41: return "SSE4.1";
+        default: return "escalar";
+    }
+}
+
+// Muestras de 8 bits en carriles de 16 bits: la suma de una muestra (y el
+// numerador del redondeo) debe caber en un int16 sin signo de 15 bits
+static bool fitsLanes16(const Kernel3x3& kernel) {
+    int bound = kernel.weightMagnitude * 255 + kernel.divisor / 2;
+    if (bound > 32767) return false;
+    return kernel.divisor == 1 || (kernel.nonNegative && bound <= kernel.reciprocalLimit);
+}
+
+// Muestras de 16 bits en carriles de 32 bits; la división se hace en float,
+// exacta mientras el numerador sea menor que 2^24
+static bool fitsLanes32(const Kernel3x3& kernel) {
+    if (kernel.divisor == 1) return true;
+    return kernel.nonNegative && (long)kernel.weightMagnitude * 65535L + kernel.divisor / 2 < (1L << 24);
+}
+
+#ifdef CONVOLUTION_X86
+
+__attribute__((target("avx2")))
+static size_t convolveU8AVX2(const uint8_t* const rows[3], uint8_t* out, size_t first, size_t last,
+                             int channels, const Kernel3x3& kernel, int maxVal) {
+    const int taps = kernel.taps;
+    const uint8_t* source[9];
+    __m256i weights[9];
+    for (int t = 0; t < taps; t++) {
+        source[t] = rows[kernel.tapRow[t]];
+        weights[t] = _mm256_set1_epi16((short)kernel.tapWeight[t]);
+    }
+    ptrdiff_t shift[9];
+    for (int t = 0; t < taps; t++) shift[t] = (ptrdiff_t)kernel.tapColumn[t] * channels;
+    
+    const bool divide = kernel.divisor > 1;
+    const __m256i half = _mm256_set1_epi16((short)(kernel.divisor / 2));
+    const __m256i reciprocal = _mm256_set1_epi16((short)kernel.reciprocal16);
+    const __m256i offset = _mm256_set1_epi16((short)kernel.offset);
+    const __m128i limit = _mm_set1_epi8((char)maxVal);
+    
+    size_t i = first;
+    for (; i + 16 <= last; i += 16) {
+        __m256i sum = _mm256_setzero_si256();
+        for (int t = 0; t < taps; t++) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source[t] + ((ptrdiff_t)i + shift[t])));
+            sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(bytes), weights[t]));
+        }
+        if (divide) {
+            sum = _mm256_mulhi_epu16(_mm256_add_epi16(sum, half), reciprocal);
+        }
+        sum = _mm256_adds_epi16(sum, offset);
+        
+        // Saturación a [0, 255] al empaquetar y después a maxVal
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_min_epu8(packed, limit));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t convolveU16AVX2(const uint16_t* const rows[3], uint16_t* out, size_t first, size_t last,
+                              int channels, const Kernel3x3& kernel, int maxVal) {
+    const int taps = kernel.taps;
+    const uint16_t* source[9];
+    __m256i weights[9];
+    ptrdiff_t shift[9];
+    for (int t = 0; t < taps; t++) {
+        source[t] = rows[kernel.tapRow[t]];
+        weights[t] = _mm256_set1_epi32(kernel.tapWeight[t]);
+        shift[t] = (ptrdiff_t)kernel.tapColumn[t] * channels;
+    }
+    
+    const bool divide = kernel.divisor > 1;
+    const __m256i half = _mm256_set1_epi32(kernel.divisor / 2);
+    const __m256 divisor = _mm256_set1_ps((float)kernel.divisor);
+    const __m256i offset = _mm256_set1_epi32(kernel.offset);
+    const __m128i limit = _mm_set1_epi16((short)maxVal);
+    
+    size_t i = first;
+    for (; i + 8 <= last; i += 8) {
+        __m256i sum = _mm256_setzero_si256();
+        for (int t = 0; t < taps; t++) {
+            __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source[t] + ((ptrdiff_t)i + shift[t])));
+            sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_cvtepu16_epi32(samples), weights[t]));
+        }
+        if (divide) {
+            __m256 numerator = _mm256_cvtepi32_ps(_mm256_add_epi32(sum, half));
+            sum = _mm256_cvttps_epi32(_mm256_div_ps(numerator, divisor));
+        }
+        sum = _mm256_add_epi32(sum, offset);
+        
+        // Saturación a [0, 65535] al empaquetar y después a maxVal
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_min_epu16(packed, limit));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t convolveU8SSE41(const uint8_t* const rows[3], uint8_t* out, size_t first, size_t last,
+                              int channels, const Kernel3x3& kernel, int maxVal) {
+    const int taps = kernel.taps;
+    const uint8_t* source[9];
+    __m128i weights[9];
+    ptrdiff_t shift[9];
+    for (int t = 0; t < taps; t++) {
+        source[t] = rows[kernel.tapRow[t]];
+        weights[t] = _mm_set1_epi16((short)kernel.tapWeight[t]);
+        shift[t] = (ptrdiff_t)kernel.tapColumn[t] * channels;
+    }
+    
+    const bool divide = kernel.divisor > 1;
+    const __m128i half = _mm_set1_epi16((short)(kernel.divisor / 2));
+    const __m128i reciprocal = _mm_set1_epi16((short)kernel.reciprocal16);
+    const __m128i offset = _mm_set1_epi16((short)kernel.offset);
+    const __m128i limit = _mm_set1_epi8((char)maxVal);
+    
+    size_t i = first;
+    for (; i + 8 <= last; i += 8) {
+        __m128i sum = _mm_setzero_si128();
+        for (int t = 0; t < taps; t++) {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source[t] + ((ptrdiff_t)i + shift[t])));
+            sum = _mm_add_epi16(sum, _mm_mullo_epi16(_mm_cvtepu8_epi16(bytes), weights[t]));
+        }
+        if (divide) {
+            sum = _mm_mulhi_epu16(_mm_add_epi16(sum, half), reciprocal);
+        }
+        sum = _mm_adds_epi16(sum, offset);
+        
+        __m128i packed = _mm_packus_epi16(sum, sum);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_min_epu8(packed, limit));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t convolveU16SSE41(const uint16_t* const rows[3], uint16_t* out, size_t first, size_t last,
+                               int channels, const Kernel3x3& kernel, int maxVal) {
+    const int taps = kernel.taps;
+    const uint16_t* source[9];
+    __m128i weights[9];
+    ptrdiff_t shift[9];
+    for (int t = 0; t < taps; t++) {
+        source[t] = rows[kernel.tapRow[t]];
+        weights[t] = _mm_set1_epi32(kernel.tapWeight[t]);
+        shift[t] = (ptrdiff_t)kernel.tapColumn[t] * channels;
+    }
+    
+    const bool divide = kernel.divisor > 1;
+    const __m128i half = _mm_set1_epi32(kernel.divisor / 2);
+    const __m128 divisor = _mm_set1_ps((float)kernel.divisor);
+    const __m128i offset = _mm_set1_epi32(kernel.offset);
+    const __m128i limit = _mm_set1_epi16((short)maxVal);
+    
+    size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        __m128i sum = _mm_setzero_si128();
+        for (int t = 0; t < taps; t++) {
+            __m128i samples = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source[t] + ((ptrdiff_t)i + shift[t])));
+            sum = _mm_add_epi32(sum, _mm_mullo_epi32(_mm_cvtepu16_epi32(samples), weights[t]));
+        }
+        if (divide) {
+            __m128 numerator = _mm_cvtepi32_ps(_mm_add_epi32(sum, half));
+            sum = _mm_cvttps_epi32(_mm_div_ps(numerator, divisor));
+        }
+        sum = _mm_add_epi32(sum, offset);
+        
+        __m128i packed = _mm_packus_epi32(sum, sum);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_min_epu16(packed, limit));
+    }
+    return i;
+}
+
+#endif // CONVOLUTION_X86
+
+size_t convolveSamplesSIMD(const uint8_t* const rows[3], uint8_t* out, size_t first, size_t last,
+                           int channels, const Kernel3x3& kernel, int maxVal) {
+    if (!kernel.integer || !fitsLanes16(kernel)) return first;
+#ifdef CONVOLUTION_X86
+    switch (getSIMDLevel()) {
+        case SIMD_AVX2: return convolveU8AVX2(rows, out, first, last, channels, kernel, maxVal);
+        case SIMD_SSE41: return convolveU8SSE41(rows, out, first, last, channels, kernel, maxVal);
+        default: break;
+    }
+#else
+    (void)rows; (void)out; (void)last; (void)channels; (void)maxVal;
+#endif
+    return first;
+}
+
+size_t convolveSamplesSIMD(const uint16_t* const rows[3], uint16_t* out, size_t first, size_t last,
+                           int channels, const Kernel3x3& kernel, int maxVal) {
+    if (!kernel.integer || !fitsLanes32(kernel)) return first;
+#ifdef CONVOLUTION_X86
+    switch (getSIMDLevel()) {
+        case SIMD_AVX2: return convolveU16AVX2(rows, out, first, last, channels, kernel, maxVal);
+        case SIMD_SSE41: return convolveU16SSE41(rows, out, first, last, channels, kernel, maxVal);
+        default: break;
+    }
+#else
+    (void)rows; (void)out; (void)last; (void)channels; (void)maxVal;
+#endif
+    return first;
+}
@@ -0,0 +1,16 @@
+#ifndef CONVOLUTIONSIMD_H
+#define CONVOLUTIONSIMD_H
+
+#include "Convolution.h"
+#include <cstddef>
+
+// Versiones vectoriales (AVX2 / SSE4.1) del kernel entero. Procesan las
+// muestras [first, last) de la fila, que deben tener vecinas a 'channels'
+// muestras a ambos lados, y devuelven el índice de la primera muestra no
+// procesada (first si el kernel o la CPU no permiten la versión vectorial)
+size_t convolveSamplesSIMD(const uint8_t* const rows[3], uint8_t* out, size_t first, size_t last,
+                           int channels, const Kernel3x3& kernel, int maxVal);
+size_t convolveSamplesSIMD(const uint16_t* const rows[3], uint16_t* out, size_t first, size_t last,
+                           int channels, const Kernel3x3& kernel, int maxVal);
+
+#endif // CONVOLUTIONSIMD_H
@@ -1,9 +1,11 @@
 #include "Image.h"
 #include <sstream>
+#include <cstdlib>
+#include <new>
 
-Image::Image() : width(0), height(0), maxVal(0), magicNumber("") {}
+Image::Image() : width(0), height(0), maxVal(0), magicNumber(""), sampleSize(1), ioThreads(1) {}
 
-Image::Image(int w, int h, int max) : width(w), height(h), maxVal(max), magicNumber("") {}
+Image::Image(int w, int h, int max) : width(w), height(h), maxVal(max), magicNumber(""), sampleSize(sampleSizeFor(max)), ioThreads(1) {}
 
 void Image::displayInfo() const {
     std::cout << "Información de la imagen:" << std::endl;
@@ -12,16 +14,32 @@ void Image::displayInfo() const {
     std::cout << "Valor máximo: " << maxVal << std::endl;
 }
 
-void Image::skipComments(std::ifstream& file) const {
-    char c;
-    while (file.peek() == '#' || file.peek() == '\n' || file.peek() == '\r' || file.peek() == ' ' || file.peek() == '\t') {
-        if (file.peek() == '#') {
-            // Saltar toda la línea de comentario
-            std::string line;
-            std::getline(file, line);
-        } else {
-            // Saltar espacios en blanco y saltos de línea
-            file.get(c);
-        }
+void Image::setBinary(bool binary) {
+    if (magicNumber == "P2" || magicNumber == "P5") {
+        magicNumber = binary ? "P5" : "P2";
+    } else if (magicNumber == "P3" || magicNumber == "P6") {
+        magicNumber = binary ? "P6" : "P3";
     }
+}
+
+void* Image::allocateAligned(size_t bytes) {
+    void* buffer = nullptr;
+    if (bytes == 0) bytes = PIXEL_ALIGNMENT;
+    if (posix_memalign(&buffer, PIXEL_ALIGNMENT, bytes) != 0) {
+        throw std::bad_alloc();
+    }
+    return buffer;
+}
+
+void Image::freeAligned(void* buffer) {
+    free(buffer);
+}
+
+int Image::alignedStride(int count, size_t elementSize) {
+    // Menor múltiplo de elementos cuyo tamaño en bytes es múltiplo de la alineación
+    size_t granularity = 1;
+    while ((granularity * elementSize) % PIXEL_ALIGNMENT != 0) {
+        granularity++;
+    }
+    return (int)(((count + granularity - 1) / granularity) * granularity);
 }
\ No newline at end of file
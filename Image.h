@@ -5,6 +5,45 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Alineación (en bytes) de los buffers de píxeles: una línea de caché
+const size_t PIXEL_ALIGNMENT = 64;
+
+// Valor máximo admitido por los formatos PNM (muestras de 16 bits)
+const int MAX_SAMPLE_VALUE = 65535;
+
+class MappedFile;
+struct ImageHeader;
+
+// Vista de una fila de muestras (puntero + longitud) sin verificación de
+// límites. RowView<const T> es de solo lectura; los iteradores son punteros
+template <typename T>
+class RowView {
+private:
+    T* first;
+    size_t count;
+    
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    
+    RowView(T* data, size_t size) : first(data), count(size) {}
+    // Una vista mutable se puede usar donde se espera una de solo lectura
+    template <typename U>
+    RowView(const RowView<U>& other) : first(other.data()), count(other.size()) {}
+    
+    T* data() const { return first; }
+    size_t size() const { return count; }
+    T& operator[](size_t i) const { return first[i]; }
+    
+    iterator begin() const { return first; }
+    iterator end() const { return first + count; }
+    const_iterator cbegin() const { return first; }
+    const_iterator cend() const { return first + count; }
+};
 
 class Image {
 protected:
@@ -12,6 +51,8 @@ protected:
     int height;
     int maxVal;
     std::string magicNumber;
+    int sampleSize;   // Bytes por muestra en memoria: 1 (uint8_t) o 2 (uint16_t)
+    int ioThreads;    // Hilos para leer y escribir archivos ASCII (1 = secuencial)
     
 public:
     // Constructor
@@ -24,6 +65,8 @@ public:
     // Métodos virtuales puros
     virtual bool readFromFile(const std::string& filename) = 0;
     virtual bool writeToFile(const std::string& filename) const = 0;
+    // Carga desde un archivo ya proyectado cuyo encabezado ya fue analizado
+    virtual bool readFromMemory(const MappedFile& file, const ImageHeader& header) = 0;
     virtual void displayInfo() const;
     
     // Getters
@@ -31,16 +74,29 @@ public:
     int getHeight() const { return height; }
     int getMaxVal() const { return maxVal; }
     std::string getMagicNumber() const { return magicNumber; }
+    int getSampleSize() const { return sampleSize; }
+    
+    // Codificación binaria (P5/P6) frente a ASCII (P2/P3)
+    bool isBinary() const { return magicNumber == "P5" || magicNumber == "P6"; }
+    void setBinary(bool binary);
+    
+    // Tamaño de muestra necesario para representar valores hasta maxVal
+    static int sampleSizeFor(int max) { return max <= 255 ? 1 : 2; }
     
     // Setters
     void setWidth(int w) { width = w; }
     void setHeight(int h) { height = h; }
     void setMaxVal(int max) { maxVal = max; }
     void setMagicNumber(const std::string& magic) { magicNumber = magic; }
+    void setIOThreads(int threads) { ioThreads = threads > 0 ? threads : 1; }
+    int getIOThreads() const { return ioThreads; }
     
 protected:
-    // Método auxiliar para leer comentarios
-    void skipComments(std::ifstream& file) const;
+    // Gestión de buffers contiguos alineados a PIXEL_ALIGNMENT
+    static void* allocateAligned(size_t bytes);
+    static void freeAligned(void* buffer);
+    // Número de elementos por fila (>= count) para que cada fila empiece alineada
+    static int alignedStride(int count, size_t elementSize);
 };
 
 #endif // IMAGE_H
\ No newline at end of file
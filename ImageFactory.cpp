@@ -1,53 +1,65 @@
 #include "ImageFactory.h"
-#include <fstream>
+#include <iostream>
 
-Image* ImageFactory::createImage(const std::string& filename) {
-    std::string magicNumber = readMagicNumber(filename);
+Image* ImageFactory::createImage(const std::string& filename, int ioThreads) {
+    MappedFile file;
+    ImageHeader header;
+    if (!probeHeader(filename, file, header)) {
+        std::cerr << "Error: Formato de archivo no soportado. Número mágico: " << std::endl;
+        return nullptr;
+    }
+    
+    Image* image = nullptr;
+    std::string type = typeForMagic(header.magicNumber);
+    if (type == "PGM") {
+        image = new PGMImage();
+    } else if (type == "PPM") {
+        image = new PPMImage();
+    } else {
+        std::cerr << "Error: Formato de archivo no soportado. Número mágico: " << header.magicNumber << std::endl;
+        return nullptr;
+    }
     
-    if (magicNumber == "P2") {
-        PGMImage* image = new PGMImage();
-        if (image->readFromFile(filename)) {
-            return image;
-        } else {
-            delete image;
-            return nullptr;
-        }
-    } else if (magicNumber == "P3") {
-        PPMImage* image = new PPMImage();
-        if (image->readFromFile(filename)) {
-            return image;
-        } else {
-            delete image;
-            return nullptr;
-        }
+    image->setIOThreads(ioThreads);
+    if (image->readFromMemory(file, header)) {
+        return image;
     } else {
-        std::cerr << "Error: Formato de archivo no soportado. Número mágico: " << magicNumber << std::endl;
+        delete image;
         return nullptr;
     }
 }
 
 std::string ImageFactory::getImageType(const std::string& filename) {
-    std::string magicNumber = readMagicNumber(filename);
-    
-    if (magicNumber == "P2") {
-        return "PGM";
-    } else if (magicNumber == "P3") {
-        return "PPM";
-    } else {
+    MappedFile file;
+    ImageHeader header;
+    if (!probeHeader(filename, file, header)) {
         return "UNKNOWN";
     }
+    return typeForMagic(header.magicNumber);
 }
 
-std::string ImageFactory::readMagicNumber(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+std::string ImageFactory::getImageType(const Image* image) {
+    if (image == nullptr) {
+        return "UNKNOWN";
+    }
+    return typeForMagic(image->getMagicNumber());
+}
+
+bool ImageFactory::probeHeader(const std::string& filename, MappedFile& file, ImageHeader& header) {
+    if (!file.open(filename)) {
         std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
-        return "";
+        return false;
+    }
+    parseImageHeader(file.data(), file.size(), header);
+    return true;
+}
+
+std::string ImageFactory::typeForMagic(const std::string& magicNumber) {
+    if (magicNumber == "P2" || magicNumber == "P5") {
+        return "PGM";
+    } else if (magicNumber == "P3" || magicNumber == "P6") {
+        return "PPM";
+    } else {
+        return "UNKNOWN";
     }
-    
-    std::string magicNumber;
-    file >> magicNumber;
-    file.close();
-    
-    return magicNumber;
 }
\ No newline at end of file
@@ -4,19 +4,26 @@
 #include "Image.h"
 #include "PGMImage.h"
 #include "PPMImage.h"
+#include "ImageIO.h"
 #include <string>
 
 class ImageFactory {
 public:
-    // Método estático para crear imagen según el tipo
-    static Image* createImage(const std::string& filename);
+    // Método estático para crear imagen según el tipo. El archivo se abre y
+    // proyecta una sola vez: el encabezado analizado aquí se reutiliza en la
+    // carga de píxeles. Con ioThreads > 1 los archivos ASCII grandes se
+    // decodifican en paralelo
+    static Image* createImage(const std::string& filename, int ioThreads = 1);
     
     // Método para determinar el tipo de imagen
     static std::string getImageType(const std::string& filename);
+    // Tipo de una imagen ya cargada (sin volver a abrir el archivo)
+    static std::string getImageType(const Image* image);
     
 private:
-    // Método auxiliar para leer el número mágico del archivo
-    static std::string readMagicNumber(const std::string& filename);
+    // Proyecta el archivo y analiza su encabezado
+    static bool probeHeader(const std::string& filename, MappedFile& file, ImageHeader& header);
+    static std::string typeForMagic(const std::string& magicNumber);
 };
 
 #endif // IMAGEFACTORY_H
\ No newline at end of file
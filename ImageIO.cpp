@@ -0,0 +1,884 @@
+#include "ImageIO.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <vector>
+
+// ============================================================================
+// MappedFile
+// ============================================================================
+
+MappedFile::MappedFile() : buffer(nullptr), length(0), mapped(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    length = (size_t)info.st_size;
+
+    if (length == 0) {
+        // mmap no admite longitud cero: buffer vacío
+        buffer = "";
+        ::close(fd);
+        return true;
+    }
+
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+        madvise(address, length, MADV_SEQUENTIAL);
+        buffer = static_cast<const char*>(address);
+        mapped = true;
+    } else {
+        // Alternativa: leer el archivo completo con llamadas grandes a read()
+        char* copy = new char[length];
+        size_t total = 0;
+        while (total < length) {
+            ssize_t n = ::read(fd, copy + total, length - total);
+            if (n <= 0) {
+                delete[] copy;
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            total += (size_t)n;
+        }
+        buffer = copy;
+    }
+
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (buffer != nullptr && length > 0) {
+        if (mapped) {
+            munmap(const_cast<char*>(buffer), length);
+        } else {
+            delete[] buffer;
+        }
+    }
+    buffer = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+// ============================================================================
+// TextScanner
+// ============================================================================
+
+// Espacios reconocidos por operator>> (isspace en la configuración "C")
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Cota para no desbordar al acumular dígitos; cualquier valor mayor se satura a maxVal
+static const uint32_t SATURATION = 0x00FFFFFF;
+
+void TextScanner::skipComments() {
+    while (current < end && (*current == '#' || *current == '\n' || *current == '\r' ||
+                             *current == ' ' || *current == '\t')) {
+        if (*current == '#') {
+            // Saltar toda la línea de comentario
+            while (current < end && *current != '\n') current++;
+            if (current < end) current++;
+        } else {
+            // Saltar espacios en blanco y saltos de línea
+            current++;
+        }
+    }
+}
+
+bool TextScanner::readToken(std::string& token) {
+    while (current < end && isSpace(*current)) current++;
+    const char* start = current;
+    while (current < end && !isSpace(*current)) current++;
+    token.assign(start, current);
+    return current != start;
+}
+
+bool TextScanner::skipSingleSpace() {
+    if (current < end && isSpace(*current)) {
+        current++;
+        return true;
+    }
+    return false;
+}
+
+bool TextScanner::readInt(int& value) {
+    value = 0;
+    while (current < end && isSpace(*current)) current++;
+
+    bool negative = false;
+    if (current < end && (*current == '-' || *current == '+')) {
+        negative = (*current == '-');
+        current++;
+    }
+    if (current == end || (unsigned)(*current - '0') > 9) {
+        return false;
+    }
+
+    uint32_t result = 0;
+    while (current < end && (unsigned)(*current - '0') <= 9) {
+        result = result * 10 + (uint32_t)(*current - '0');
+        result = result > SATURATION ? SATURATION : result;
+        current++;
+    }
+    value = negative ? -(int)result : (int)result;
+    return true;
+}
+
+template <typename T>
+size_t TextScanner::readSamplesImpl(T* out, size_t count, int maxVal) {
+    const char* p = current;
+    const char* const stop = end;
+    const uint32_t limit = (uint32_t)maxVal;
+    size_t n = 0;
+
+    for (; n < count; n++) {
+        while (p < stop && isSpace(*p)) p++;
+        if (p == stop) break;
+
+        // Un signo es válido para operator>>; los negativos se saturan a 0
+        bool negative = false;
+        if (*p == '-' || *p == '+') {
+            negative = (*p == '-');
+            p++;
+        }
+
+        unsigned digit;
+        if (p == stop || (digit = (unsigned)(*p - '0')) > 9) break;
+
+        uint32_t value = 0;
+        do {
+            value = value * 10 + digit;
+            value = value > SATURATION ? SATURATION : value;
+            p++;
+        } while (p < stop && (digit = (unsigned)(*p - '0')) <= 9);
+
+        value = negative ? 0 : value;
+        out[n] = (T)(value < limit ? value : limit);
+    }
+
+    current = p;
+    return n;
+}
+
+size_t TextScanner::readSamples(uint8_t* out, size_t count, int maxVal) {
+    return readSamplesImpl(out, count, maxVal);
+}
+
+size_t TextScanner::readSamples(uint16_t* out, size_t count, int maxVal) {
+    return readSamplesImpl(out, count, maxVal);
+}
+
+const char* nextSpace(const char* p, const char* end) {
+    while (p < end && !isSpace(*p)) p++;
+    return p;
+}
+
+// Clases de bytes para contar tokens con las mismas fronteras que
+// readSamples: un token es un signo opcional seguido de dígitos, así que
+// "12-7" son dos muestras. Cualquier otro byte empieza un token propio, que
+// readSamples rechaza con el error habitual
+enum ByteClass { BYTE_SPACE, BYTE_SIGN, BYTE_DIGIT, BYTE_OTHER };
+
+static inline int byteClass(char c) {
+    if (isSpace(c)) return BYTE_SPACE;
+    if ((unsigned)(c - '0') <= 9) return BYTE_DIGIT;
+    return (c == '-' || c == '+') ? BYTE_SIGN : BYTE_OTHER;
+}
+
+// true si un byte de clase 'current' tras uno de clase 'previous' empieza un token
+static inline bool startsToken(int previous, int current) {
+    if (current == BYTE_SPACE) return false;
+    if (current == BYTE_DIGIT) return previous == BYTE_SPACE || previous == BYTE_OTHER;
+    return true;
+}
+
+size_t countTokens(const char* begin, const char* end) {
+    size_t tokens = 0;
+    int previous = BYTE_SPACE;
+    for (const char* p = begin; p < end; p++) {
+        int current = byteClass(*p);
+        tokens += startsToken(previous, current) ? 1 : 0;
+        previous = current;
+    }
+    return tokens;
+}
+
+const char* skipTokens(const char* p, const char* end, size_t count) {
+    int previous = BYTE_SPACE;
+    for (; p < end; p++) {
+        int current = byteClass(*p);
+        if (startsToken(previous, current)) {
+            if (count == 0) return p;
+            count--;
+        }
+        previous = current;
+    }
+    return end;
+}
+
+// ============================================================================
+// Encabezado
+// ============================================================================
+
+void parseImageHeader(const char* data, size_t size, ImageHeader& header) {
+    TextScanner scanner(data, data + size);
+    header = ImageHeader();
+
+    // Número mágico
+    scanner.readToken(header.magicNumber);
+    scanner.skipComments();
+
+    // Dimensiones
+    if (scanner.readInt(header.width)) scanner.readInt(header.height);
+    scanner.skipComments();
+
+    // Valor máximo
+    scanner.readInt(header.maxVal);
+
+    // Los formatos binarios llevan exactamente un espacio antes de los datos
+    if (header.magicNumber == "P5" || header.magicNumber == "P6") {
+        header.dataOffset = scanner.skipSingleSpace() ? (size_t)(scanner.position() - data) : size;
+    } else {
+        header.dataOffset = (size_t)(scanner.position() - data);
+    }
+}
+
+// ============================================================================
+// Decodificación ASCII en paralelo
+// ============================================================================
+
+// Tramos menores no compensan el coste de crear hilos
+static const size_t MIN_PARSE_CHUNK = 256 * 1024;
+
+// Estado de cada hilo de decodificación
+struct ParseChunk {
+    const char* begin;
+    const char* end;
+    unsigned char* firstRow;
+    size_t stride;
+    size_t samplesPerRow;
+    size_t totalSamples;
+    int maxVal;
+    size_t tokens;        // Fase 1: tokens del tramo
+    size_t firstIndex;    // Fase 2: índice global del primer token del tramo
+    size_t errorIndex;    // Fase 2: índice global del primer error (o totalSamples)
+    bool wide;            // Muestras uint16_t
+};
+
+static void* countTokensThread(void* arg) {
+    ParseChunk* chunk = static_cast<ParseChunk*>(arg);
+    chunk->tokens = countTokens(chunk->begin, chunk->end);
+    return nullptr;
+}
+
+template <typename T>
+static void decodeChunk(ParseChunk* chunk) {
+    TextScanner scanner(chunk->begin, chunk->end);
+    size_t index = chunk->firstIndex;
+    size_t last = chunk->firstIndex + chunk->tokens;
+    if (last > chunk->totalSamples) last = chunk->totalSamples;
+    chunk->errorIndex = chunk->totalSamples;
+
+    // Recorrer las filas que cubre el tramo, decodificando segmentos contiguos
+    while (index < last) {
+        size_t row = index / chunk->samplesPerRow;
+        size_t column = index % chunk->samplesPerRow;
+        size_t count = chunk->samplesPerRow - column;
+        if (count > last - index) count = last - index;
+
+        T* out = reinterpret_cast<T*>(chunk->firstRow + row * chunk->stride) + column;
+        size_t read = scanner.readSamples(out, count, chunk->maxVal);
+        if (read < count) {
+            chunk->errorIndex = index + read;
+            return;
+        }
+        index += count;
+    }
+}
+
+static void* decodeThread(void* arg) {
+    ParseChunk* chunk = static_cast<ParseChunk*>(arg);
+    if (chunk->wide) {
+        decodeChunk<uint16_t>(chunk);
+    } else {
+        decodeChunk<uint8_t>(chunk);
+    }
+    return nullptr;
+}
+
+// Ejecuta 'function' sobre cada tramo, uno por hilo (el tramo 0 en el hilo actual)
+template <typename Chunk>
+static bool runChunks(std::vector<Chunk>& chunks, void* (*function)(void*)) {
+    std::vector<pthread_t> threads(chunks.size());
+    size_t created = 1;
+    bool ok = true;
+    for (; created < chunks.size(); created++) {
+        if (pthread_create(&threads[created], nullptr, function, &chunks[created]) != 0) {
+            ok = false;
+            break;
+        }
+    }
+    function(&chunks[0]);
+    for (size_t i = 1; i < created; i++) {
+        pthread_join(threads[i], nullptr);
+    }
+    return ok;
+}
+
+static size_t readSamplesParallelImpl(const char* begin, const char* end, unsigned char* firstRow,
+                                      size_t stride, size_t samplesPerRow, size_t rows,
+                                      int maxVal, int numThreads, bool wide) {
+    size_t totalSamples = samplesPerRow * rows;
+    size_t length = (size_t)(end - begin);
+
+    size_t numChunks = numThreads > 1 ? (size_t)numThreads : 1;
+    if (numChunks > length / MIN_PARSE_CHUNK) numChunks = length / MIN_PARSE_CHUNK;
+    if (numChunks < 1) numChunks = 1;
+
+    // Dividir en tramos de igual tamaño y mover cada frontera hasta un espacio
+    std::vector<ParseChunk> chunks(numChunks);
+    const char* start = begin;
+    for (size_t i = 0; i < numChunks; i++) {
+        const char* stop = (i == numChunks - 1) ? end : begin + length / numChunks * (i + 1);
+        if (stop < start) stop = start;
+        stop = nextSpace(stop, end);
+
+        ParseChunk& chunk = chunks[i];
+        chunk.begin = start;
+        chunk.end = stop;
+        chunk.firstRow = firstRow;
+        chunk.stride = stride;
+        chunk.samplesPerRow = samplesPerRow;
+        chunk.totalSamples = totalSamples;
+        chunk.maxVal = maxVal;
+        chunk.tokens = 0;
+        chunk.firstIndex = 0;
+        chunk.errorIndex = totalSamples;
+        chunk.wide = wide;
+        start = stop;
+    }
+
+    // Fase 1: contar tokens por tramo
+    if (!runChunks(chunks, countTokensThread)) {
+        return 0;
+    }
+
+    // Suma de prefijos: índice global del primer token de cada tramo
+    size_t index = 0;
+    for (size_t i = 0; i < numChunks; i++) {
+        chunks[i].firstIndex = index;
+        index += chunks[i].tokens;
+    }
+    size_t available = index < totalSamples ? index : totalSamples;
+
+    // Fase 2: decodificar cada tramo en su posición (sólo los que aportan muestras)
+    size_t active = 0;
+    while (active < numChunks && chunks[active].firstIndex < totalSamples) active++;
+    std::vector<ParseChunk> work(chunks.begin(), chunks.begin() + (active > 0 ? active : 1));
+    if (!runChunks(work, decodeThread)) {
+        return 0;
+    }
+
+    // El primer error (por índice global) determina cuántas muestras son válidas
+    size_t valid = available;
+    for (size_t i = 0; i < work.size(); i++) {
+        if (work[i].errorIndex < valid) valid = work[i].errorIndex;
+    }
+    return valid;
+}
+
+size_t readSamplesParallel(const char* begin, const char* end, uint8_t* firstRow, size_t stride,
+                           size_t samplesPerRow, size_t rows, int maxVal, int numThreads) {
+    return readSamplesParallelImpl(begin, end, firstRow, stride, samplesPerRow, rows,
+                                   maxVal, numThreads, false);
+}
+
+size_t readSamplesParallel(const char* begin, const char* end, uint16_t* firstRow, size_t stride,
+                           size_t samplesPerRow, size_t rows, int maxVal, int numThreads) {
+    return readSamplesParallelImpl(begin, end, reinterpret_cast<unsigned char*>(firstRow), stride,
+                                   samplesPerRow, rows, maxVal, numThreads, true);
+}
+
+// ============================================================================
+// BufferedWriter
+// ============================================================================
+
+BufferedWriter::BufferedWriter() : fd(-1), buffer(nullptr), capacity(0), used(0), failed(false) {}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+bool BufferedWriter::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    buffer = new char[BUFFER_SIZE];
+    capacity = BUFFER_SIZE;
+    used = 0;
+    failed = false;
+    return true;
+}
+
+// Escribe todos los bytes reintentando escrituras parciales
+static bool writeAll(int fd, const char* data, size_t count) {
+    while (count > 0) {
+        ssize_t n = ::write(fd, data, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        count -= (size_t)n;
+    }
+    return true;
+}
+
+bool BufferedWriter::write(const char* data, size_t count) {
+    if (fd < 0 || failed) return false;
+
+    if (used + count > capacity) {
+        if (!flush()) return false;
+        // Bloques más grandes que el buffer se escriben directamente
+        if (count >= capacity) {
+            failed = !writeAll(fd, data, count);
+            return !failed;
+        }
+    }
+    memcpy(buffer + used, data, count);
+    used += count;
+    return true;
+}
+
+char* BufferedWriter::reserve(size_t count) {
+    if (fd < 0 || failed) return nullptr;
+
+    if (used + count > capacity) {
+        if (!flush()) return nullptr;
+        if (count > capacity) {
+            // Una sola reserva mayor que el buffer: agrandarlo
+            delete[] buffer;
+            buffer = new char[count];
+            capacity = count;
+        }
+    }
+    return buffer + used;
+}
+
+bool BufferedWriter::flush() {
+    if (fd < 0 || failed) return false;
+    if (used > 0) {
+        failed = !writeAll(fd, buffer, used);
+        used = 0;
+    }
+    return !failed;
+}
+
+bool BufferedWriter::close() {
+    bool ok = true;
+    if (fd >= 0) {
+        ok = flush();
+        if (::close(fd) != 0) ok = false;
+        fd = -1;
+    }
+    delete[] buffer;
+    buffer = nullptr;
+    capacity = 0;
+    used = 0;
+    return ok && !failed;
+}
+
+// ============================================================================
+// Muestras binarias P5/P6
+// ============================================================================
+
+void decodeBinarySamples(const char* src, uint8_t* out, size_t count, int maxVal) {
+    memcpy(out, src, count);
+    if (maxVal < 255) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = out[i] > maxVal ? (uint8_t)maxVal : out[i];
+        }
+    }
+}
+
+void decodeBinarySamples(const char* src, uint16_t* out, size_t count, int maxVal) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(src);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t value = (uint16_t)((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+        out[i] = value > maxVal ? (uint16_t)maxVal : value;
+    }
+}
+
+void encodeBinarySamples(const uint16_t* in, size_t count, char* dst) {
+    for (size_t i = 0; i < count; i++) {
+        dst[2 * i] = (char)(in[i] >> 8);
+        dst[2 * i + 1] = (char)(in[i] & 0xFF);
+    }
+}
+
+// ============================================================================
+// Formato ASCII
+// ============================================================================
+
+// Tabla de pares de dígitos "00".."99"
+static const char DIGIT_PAIRS[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Escribe value (<= 65535) en decimal y devuelve el puntero siguiente
+static inline char* formatSample(char* dst, uint32_t value) {
+    if (value < 10) {
+        dst[0] = (char)('0' + value);
+        return dst + 1;
+    }
+    if (value < 100) {
+        memcpy(dst, DIGIT_PAIRS + 2 * value, 2);
+        return dst + 2;
+    }
+    if (value < 1000) {
+        dst[0] = (char)('0' + value / 100);
+        memcpy(dst + 1, DIGIT_PAIRS + 2 * (value % 100), 2);
+        return dst + 3;
+    }
+    if (value < 10000) {
+        memcpy(dst, DIGIT_PAIRS + 2 * (value / 100), 2);
+        memcpy(dst + 2, DIGIT_PAIRS + 2 * (value % 100), 2);
+        return dst + 4;
+    }
+    dst[0] = (char)('0' + value / 10000);
+    value %= 10000;
+    memcpy(dst + 1, DIGIT_PAIRS + 2 * (value / 100), 2);
+    memcpy(dst + 3, DIGIT_PAIRS + 2 * (value % 100), 2);
+    return dst + 5;
+}
+
+template <typename T>
+static size_t formatAsciiRowImpl(const T* samples, size_t count, int channels, char* dst) {
+    char* p = dst;
+    if (channels == 1) {
+        for (size_t i = 0; i < count; i++) {
+            p = formatSample(p, samples[i]);
+            *p++ = ' ';
+        }
+    } else {
+        for (size_t i = 0; i < count; i += channels) {
+            for (int c = 0; c < channels; c++) {
+                p = formatSample(p, samples[i + c]);
+                *p++ = ' ';
+            }
+            *p++ = ' ';
+        }
+        // El último píxel no lleva el separador doble
+        if (count > 0) p--;
+    }
+    // Sustituir el último separador por el fin de línea
+    if (count > 0) p--;
+    *p++ = '\n';
+    return (size_t)(p - dst);
+}
+
+size_t formatAsciiRow(const uint8_t* samples, size_t count, int channels, char* dst) {
+    return formatAsciiRowImpl(samples, count, channels, dst);
+}
+
+size_t formatAsciiRow(const uint16_t* samples, size_t count, int channels, char* dst) {
+    return formatAsciiRowImpl(samples, count, channels, dst);
+}
+
+// ============================================================================
+// Escritura ASCII en paralelo
+// ============================================================================
+
+// Bandas menores no compensan el coste de crear hilos
+static const size_t MIN_FORMAT_SAMPLES = 128 * 1024;
+
+// Estado de cada hilo de escritura: una banda de filas y su buffer propio
+struct FormatBand {
+    const unsigned char* firstRow;
+    size_t stride;
+    size_t samplesPerRow;
+    size_t startRow;
+    size_t endRow;
+    int channels;
+    bool wide;
+    std::vector<char> text;   // Fase 1: texto formateado de la banda
+    int fd;
+    off_t offset;             // Fase 2: desplazamiento de la banda en el archivo
+    bool ok;
+};
+
+static void* formatBandThread(void* arg) {
+    FormatBand* band = static_cast<FormatBand*>(arg);
+    size_t lineCapacity = asciiRowCapacity(band->samplesPerRow);
+    band->text.resize(lineCapacity * (band->endRow - band->startRow));
+
+    size_t length = 0;
+    for (size_t y = band->startRow; y < band->endRow; y++) {
+        const unsigned char* row = band->firstRow + y * band->stride;
+        char* line = band->text.data() + length;
+        length += band->wide
+            ? formatAsciiRow(reinterpret_cast<const uint16_t*>(row), band->samplesPerRow, band->channels, line)
+            : formatAsciiRow(reinterpret_cast<const uint8_t*>(row), band->samplesPerRow, band->channels, line);
+    }
+    band->text.resize(length);
+    return nullptr;
+}
+
+static void* writeBandThread(void* arg) {
+    FormatBand* band = static_cast<FormatBand*>(arg);
+    const char* data = band->text.data();
+    size_t count = band->text.size();
+    off_t offset = band->offset;
+    band->ok = true;
+    while (count > 0) {
+        ssize_t n = pwrite(band->fd, data, count, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            band->ok = false;
+            break;
+        }
+        data += n;
+        count -= (size_t)n;
+        offset += n;
+    }
+    return nullptr;
+}
+
+static bool writeAsciiParallelImpl(const std::string& filename, const std::string& header,
+                                   const unsigned char* firstRow, size_t stride, size_t samplesPerRow,
+                                   size_t rows, int channels, int numThreads, bool wide) {
+    size_t numBands = numThreads > 1 ? (size_t)numThreads : 1;
+    size_t maxBands = samplesPerRow * rows / MIN_FORMAT_SAMPLES;
+    if (numBands > maxBands) numBands = maxBands;
+    if (numBands > rows) numBands = rows;
+    if (numBands < 1) numBands = 1;
+
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Fase 1: cada hilo formatea su banda de filas en su propio buffer
+    std::vector<FormatBand> bands(numBands);
+    for (size_t i = 0; i < numBands; i++) {
+        FormatBand& band = bands[i];
+        band.firstRow = firstRow;
+        band.stride = stride;
+        band.samplesPerRow = samplesPerRow;
+        band.startRow = rows * i / numBands;
+        band.endRow = rows * (i + 1) / numBands;
+        band.channels = channels;
+        band.wide = wide;
+        band.fd = fd;
+        band.offset = 0;
+        band.ok = false;
+    }
+    bool ok = runChunks(bands, formatBandThread);
+
+    // Suma de prefijos de las longitudes: desplazamiento de cada banda
+    off_t offset = (off_t)header.size();
+    for (size_t i = 0; i < numBands; i++) {
+        bands[i].offset = offset;
+        offset += (off_t)bands[i].text.size();
+    }
+
+    // Fase 2: encabezado y bandas se escriben en paralelo con pwrite
+    FormatBand headerBand;
+    headerBand.text.assign(header.begin(), header.end());
+    headerBand.fd = fd;
+    headerBand.offset = 0;
+    writeBandThread(&headerBand);
+    ok = ok && headerBand.ok && runChunks(bands, writeBandThread);
+    for (size_t i = 0; i < numBands; i++) {
+        ok = ok && bands[i].ok;
+    }
+
+    if (::close(fd) != 0) ok = false;
+    return ok;
+}
+
+bool writeAsciiParallel(const std::string& filename, const std::string& header, const uint8_t* firstRow,
+                        size_t stride, size_t samplesPerRow, size_t rows, int channels, int numThreads) {
+    return writeAsciiParallelImpl(filename, header, firstRow, stride, samplesPerRow, rows,
+                                  channels, numThreads, false);
+}
+
+bool writeAsciiParallel(const std::string& filename, const std::string& header, const uint16_t* firstRow,
+                        size_t stride, size_t samplesPerRow, size_t rows, int channels, int numThreads) {
+    return writeAsciiParallelImpl(filename, header, reinterpret_cast<const unsigned char*>(firstRow),
+                                  stride, samplesPerRow, rows, channels, numThreads, true);
+}
+
+// ============================================================================
+// Lectura y escritura fila a fila (modo streaming)
+// ============================================================================
+
+RowReader::RowReader() : fd(-1), buffer(nullptr), capacity(0), begin(0), end(0), eof(false) {}
+
+RowReader::~RowReader() {
+    close();
+}
+
+bool RowReader::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    buffer = new char[BUFFER_SIZE];
+    capacity = BUFFER_SIZE;
+    begin = end = 0;
+    eof = false;
+
+    // El encabezado debe quedar completo en el buffer: si su último campo
+    // toca el final de los datos leídos, puede estar cortado
+    fill();
+    parseImageHeader(buffer, end, header);
+    while (!eof && header.dataOffset >= end) {
+        fill();
+        parseImageHeader(buffer, end, header);
+    }
+    begin = header.dataOffset;
+    return true;
+}
+
+void RowReader::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    delete[] buffer;
+    buffer = nullptr;
+    capacity = 0;
+    begin = end = 0;
+    eof = false;
+}
+
+bool RowReader::fill() {
+    if (eof) return false;
+
+    if (begin > 0) {
+        memmove(buffer, buffer + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == capacity) {
+        // Un único token o encabezado mayor que el buffer
+        char* larger = new char[capacity * 2];
+        memcpy(larger, buffer, end);
+        delete[] buffer;
+        buffer = larger;
+        capacity *= 2;
+    }
+
+    ssize_t n;
+    do {
+        n = ::read(fd, buffer + end, capacity - end);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        eof = true;
+        return false;
+    }
+    end += (size_t)n;
+    return true;
+}
+
+template <typename T>
+size_t RowReader::readRowImpl(T* out, size_t count) {
+    if (fd < 0) return 0;
+
+    if (header.magicNumber == "P5" || header.magicNumber == "P6") {
+        size_t rowBytes = count * sizeof(T);
+        while (end - begin < rowBytes && fill()) {}
+        if (end - begin < rowBytes) {
+            return (end - begin) / sizeof(T);
+        }
+        decodeBinarySamples(buffer + begin, out, count, header.maxVal);
+        begin += rowBytes;
+        return count;
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        // Solo se analiza hasta el último espacio para no cortar un token
+        // entre dos lecturas; al final del archivo se analiza todo
+        const char* data = buffer + begin;
+        const char* safe = buffer + end;
+        if (!eof) {
+            while (safe > data && !isSpace(safe[-1])) safe--;
+        }
+
+        TextScanner scanner(data, safe);
+        done += scanner.readSamples(out + done, count - done, header.maxVal);
+        begin = (size_t)(scanner.position() - buffer);
+        if (done == count) break;
+
+        // Un fallo antes del límite es un error de formato; en el límite
+        // simplemente faltan datos
+        if (scanner.position() != safe || eof) break;
+        fill();
+    }
+    return done;
+}
+
+size_t RowReader::readRow(uint8_t* out, size_t count) {
+    return readRowImpl(out, count);
+}
+
+size_t RowReader::readRow(uint16_t* out, size_t count) {
+    return readRowImpl(out, count);
+}
+
+bool RowWriter::open(const std::string& filename, const std::string& header, bool binaryOutput, int samplesPerPixel) {
+    binary = binaryOutput;
+    channels = samplesPerPixel;
+    if (!file.open(filename)) {
+        return false;
+    }
+    return file.write(header);
+}
+
+bool RowWriter::writeRow(const uint8_t* samples, size_t count) {
+    if (binary) {
+        return file.write(reinterpret_cast<const char*>(samples), count);
+    }
+    char* line = file.reserve(asciiRowCapacity(count));
+    if (line == nullptr) return false;
+    file.commit(formatAsciiRow(samples, count, channels, line));
+    return true;
+}
+
+bool RowWriter::writeRow(const uint16_t* samples, size_t count) {
+    if (binary) {
+        encoded.resize(count * 2);
+        encodeBinarySamples(samples, count, encoded.data());
+        return file.write(encoded.data(), encoded.size());
+    }
+    char* line = file.reserve(asciiRowCapacity(count));
+    if (line == nullptr) return false;
+    file.commit(formatAsciiRow(samples, count, channels, line));
+    return true;
+}
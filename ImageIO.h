@@ -0,0 +1,217 @@
+#ifndef IMAGEIO_H
+#define IMAGEIO_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Archivo completo proyectado en memoria (solo lectura)
+class MappedFile {
+private:
+    const char* buffer;
+    size_t length;
+    bool mapped;   // true si proviene de mmap, false si se leyó a memoria dinámica
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return buffer; }
+    size_t size() const { return length; }
+
+private:
+    // No copiable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// Analizador de texto ASCII para encabezados y muestras PNM sobre un buffer
+class TextScanner {
+private:
+    const char* current;
+    const char* end;
+
+public:
+    TextScanner(const char* begin, const char* finish) : current(begin), end(finish) {}
+
+    // Salta espacios y líneas de comentario ('#' hasta fin de línea)
+    void skipComments();
+
+    // Equivalentes a "file >> token" y "file >> value"
+    bool readToken(std::string& token);
+    bool readInt(int& value);
+
+    // Lee hasta 'count' muestras consecutivas, saturadas a [0, maxVal].
+    // Devuelve cuántas se leyeron correctamente
+    size_t readSamples(uint8_t* out, size_t count, int maxVal);
+    size_t readSamples(uint16_t* out, size_t count, int maxVal);
+
+    // Consume el único espacio que separa maxVal de los datos binarios (P5/P6)
+    bool skipSingleSpace();
+
+    const char* position() const { return current; }
+
+private:
+    template <typename T>
+    size_t readSamplesImpl(T* out, size_t count, int maxVal);
+};
+
+// Utilidades para repartir texto ASCII por tramos (espacios según isspace).
+// nextSpace avanza hasta el primer espacio (o end): un tramo que empieza en un
+// espacio nunca corta un token. countTokens cuenta los tokens que empiezan en
+// [begin, end) y skipTokens salta 'count' tokens desde p (que debe estar al
+// inicio de un token o en un espacio). Los tokens se separan igual que en
+// TextScanner::readSamples: "12-7" son dos tokens y "12x" dos, el segundo
+// inválido, de modo que las muestras se ubican igual que en la lectura
+// secuencial y los errores aparecen en la misma posición
+const char* nextSpace(const char* p, const char* end);
+size_t countTokens(const char* begin, const char* end);
+const char* skipTokens(const char* p, const char* end, size_t count);
+
+// Decodifica en paralelo las muestras ASCII de [begin, end) hacia 'rows' filas
+// de 'samplesPerRow' muestras que empiezan cada 'stride' bytes a partir de
+// 'firstRow'. Divide el texto en tramos alineados a espacios, cuenta los tokens
+// de cada tramo en paralelo y, tras una suma de prefijos, cada hilo decodifica
+// su tramo directamente en su posición final. Devuelve cuántas muestras se
+// leyeron antes del primer error (rows * samplesPerRow si no hubo errores)
+size_t readSamplesParallel(const char* begin, const char* end, uint8_t* firstRow, size_t stride,
+                           size_t samplesPerRow, size_t rows, int maxVal, int numThreads);
+size_t readSamplesParallel(const char* begin, const char* end, uint16_t* firstRow, size_t stride,
+                           size_t samplesPerRow, size_t rows, int maxVal, int numThreads);
+
+// Encabezado PNM ya analizado
+struct ImageHeader {
+    std::string magicNumber;
+    int width;
+    int height;
+    int maxVal;
+    size_t dataOffset;   // Primer byte de la sección de píxeles
+
+    ImageHeader() : width(0), height(0), maxVal(0), dataOffset(0) {}
+};
+
+// Analiza número mágico, dimensiones y maxVal (con las reglas de comentarios de
+// TextScanner::skipComments) sin validar los valores. En P5/P6 dataOffset ya
+// descuenta el espacio separador; si falta, dataOffset == size
+void parseImageHeader(const char* data, size_t size, ImageHeader& header);
+
+// Escritura a archivo con un buffer grande y pocas llamadas a write()
+class BufferedWriter {
+private:
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    bool failed;
+
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    BufferedWriter();
+    ~BufferedWriter();
+
+    bool open(const std::string& filename);
+    bool write(const char* data, size_t count);
+    bool write(const std::string& text) { return write(text.data(), text.size()); }
+    // Espacio contiguo para formatear hasta 'count' bytes directamente en el
+    // buffer; commit() confirma los bytes realmente usados
+    char* reserve(size_t count);
+    void commit(size_t count) { used += count; }
+    bool flush();
+    // Vacía el buffer y cierra; devuelve false si alguna escritura falló
+    bool close();
+
+private:
+    // No copiable
+    BufferedWriter(const BufferedWriter&);
+    BufferedWriter& operator=(const BufferedWriter&);
+};
+
+// Conversión entre el buffer de la imagen y muestras binarias PNM
+// (1 byte, o 2 bytes big-endian cuando maxVal > 255). La lectura satura a maxVal
+void decodeBinarySamples(const char* src, uint8_t* out, size_t count, int maxVal);
+void decodeBinarySamples(const char* src, uint16_t* out, size_t count, int maxVal);
+void encodeBinarySamples(const uint16_t* in, size_t count, char* dst);
+
+// Formato ASCII de una fila, idéntico al de operator<<: muestras separadas por
+// un espacio, píxeles (grupos de 'channels' muestras) por dos espacios si
+// channels > 1, y '\n' final. Devuelve los bytes escritos en dst, que debe
+// tener al menos asciiRowCapacity(count) bytes
+size_t formatAsciiRow(const uint8_t* samples, size_t count, int channels, char* dst);
+size_t formatAsciiRow(const uint16_t* samples, size_t count, int channels, char* dst);
+inline size_t asciiRowCapacity(size_t count) { return count * 7 + 1; }
+
+// Escribe 'header' seguido de las filas en ASCII formateando bandas de filas en
+// paralelo, cada una en su propio buffer; tras una suma de prefijos de las
+// longitudes cada banda se escribe con pwrite en su desplazamiento. El archivo
+// es idéntico al que produce el escritor secuencial
+bool writeAsciiParallel(const std::string& filename, const std::string& header, const uint8_t* firstRow,
+                        size_t stride, size_t samplesPerRow, size_t rows, int channels, int numThreads);
+bool writeAsciiParallel(const std::string& filename, const std::string& header, const uint16_t* firstRow,
+                        size_t stride, size_t samplesPerRow, size_t rows, int channels, int numThreads);
+
+// Lectura fila a fila con memoria acotada (modo streaming). Solo mantiene un
+// buffer de lectura de tamaño fijo, independiente del tamaño de la imagen
+class RowReader {
+private:
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t begin;   // Primer byte pendiente de consumir
+    size_t end;     // Fin de los datos válidos del buffer
+    bool eof;
+    ImageHeader header;
+
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    RowReader();
+    ~RowReader();
+
+    // Abre el archivo y analiza el encabezado (sin validar sus valores)
+    bool open(const std::string& filename);
+    void close();
+
+    const ImageHeader& getHeader() const { return header; }
+
+    // Lee las 'count' muestras de la siguiente fila (ASCII o binario según el
+    // número mágico). Devuelve cuántas se leyeron antes del primer error
+    size_t readRow(uint8_t* out, size_t count);
+    size_t readRow(uint16_t* out, size_t count);
+
+private:
+    // Mueve los datos pendientes al inicio y lee más del archivo; agranda el
+    // buffer si ya estaba lleno. Devuelve false al llegar al final del archivo
+    bool fill();
+
+    template <typename T>
+    size_t readRowImpl(T* out, size_t count);
+
+    // No copiable
+    RowReader(const RowReader&);
+    RowReader& operator=(const RowReader&);
+};
+
+// Escritura fila a fila (modo streaming) con el mismo formato que writeToFile
+class RowWriter {
+private:
+    BufferedWriter file;
+    bool binary;
+    int channels;
+    std::vector<char> encoded;   // Fila codificada en big-endian (16 bits)
+
+public:
+    RowWriter() : binary(false), channels(1) {}
+
+    bool open(const std::string& filename, const std::string& header, bool binaryOutput, int samplesPerPixel);
+    bool writeRow(const uint8_t* samples, size_t count);
+    bool writeRow(const uint16_t* samples, size_t count);
+    // Vacía el buffer y cierra; devuelve false si alguna escritura falló
+    bool close() { return file.close(); }
+};
+
+#endif // IMAGEIO_H
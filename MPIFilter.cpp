@@ -1,206 +1,951 @@
-// Versión simplificada de MPI que funciona
 #include "MPIFilter.h"
 #include "PGMImage.h"
 #include "PPMImage.h"
+#include "OMPFilter.h"
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
 
-Image* MPIFilter::applyFilterDistributed(const Image* input, Filter* filter, 
-                                        int rank, int size) {
-    if (!input || !filter) return nullptr;
+// Etiqueta de los mensajes punto a punto con filas de píxeles
+static const int TAG_ROWS = 1;
+
+bool MPIFilter::overlap = false;
+int MPIFilter::threads = 1;
+int MPIFilter::iterations = 1;
+
+void MPIFilter::setOverlap(bool enabled) {
+    overlap = enabled;
+}
+
+void MPIFilter::setIterations(int count) {
+    iterations = count > 0 ? count : 1;
+}
+
+void MPIFilter::setThreads(int count) {
+    threads = count > 0 ? count : omp_get_max_threads();
+    omp_set_num_threads(threads);
+}
+
+RowDecomposition::RowDecomposition(int height, int size) : counts(size), starts(size) {
+    int base = height / size;
+    int extra = height % size;
+    int start = 0;
+    for (int i = 0; i < size; i++) {
+        counts[i] = base + (i < extra ? 1 : 0);
+        starts[i] = start;
+        start += counts[i];
+    }
+}
+
+BlockDecomposition::BlockDecomposition(int width, int height, int size)
+    : rows(height, 1), cols(width, 1) {
+    // Cada proceso envía y recibe tantos píxeles de halo como el perímetro de
+    // su bloque, así que entre las factorizaciones size = dims[0] * dims[1] se
+    // elige la que minimiza filas + columnas del bloque más grande
+    // (MPI_Dims_create no tiene en cuenta la forma de la imagen). Se prefieren
+    // mallas sin bloques vacíos y, a igualdad, más filas de procesos: bloques
+    // más anchos con filas contiguas más largas
+    int bestRows = size;
+    long long bestCost = -1;
+    bool bestFits = false;
+    for (int gridRows = size; gridRows >= 1; gridRows--) {
+        if (size % gridRows != 0) continue;
+        int gridCols = size / gridRows;
+        bool fits = gridRows <= height && gridCols <= width;
+        long long cost = (long long)(height + gridRows - 1) / gridRows + (width + gridCols - 1) / gridCols;
+        if (bestCost < 0 || (fits && !bestFits) || (fits == bestFits && cost < bestCost)) {
+            bestRows = gridRows;
+            bestCost = cost;
+            bestFits = fits;
+        }
+    }
+    
+    dims[0] = bestRows;
+    dims[1] = size / bestRows;
+    rows = RowDecomposition(height, dims[0]);
+    cols = RowDecomposition(width, dims[1]);
+}
+
+// Primer byte de la fila y. Las filas de una imagen están separadas por
+// exactamente getStride() bytes, así que 'n' filas consecutivas son un solo
+// bloque contiguo de memoria
+template <typename ImageType>
+static unsigned char* rowBytes(ImageType* image, int y) {
+    if (image->getSampleSize() == 1) {
+        return reinterpret_cast<unsigned char*>(image->template row<uint8_t>(y).data());
+    }
+    return reinterpret_cast<unsigned char*>(image->template row<uint16_t>(y).data());
+}
+
+static unsigned char* rowAddress(Image* image, int y) {
+    PGMImage* pgm = dynamic_cast<PGMImage*>(image);
+    return pgm ? rowBytes(pgm, y) : rowBytes(static_cast<PPMImage*>(image), y);
+}
+
+static const unsigned char* rowAddress(const Image* image, int y) {
+    return rowAddress(const_cast<Image*>(image), y);
+}
+
+// Bytes entre el inicio de dos filas consecutivas
+static int rowStride(const Image* image) {
+    const PGMImage* pgm = dynamic_cast<const PGMImage*>(image);
+    return pgm ? pgm->getStride() : static_cast<const PPMImage*>(image)->getStride();
+}
+
+// Bytes de un píxel (todas sus muestras)
+static int pixelBytes(const Image* image) {
+    int channels = dynamic_cast<const PPMImage*>(image) ? 3 : 1;
+    return channels * image->getSampleSize();
+}
+
+// Primer byte del píxel (x, y)
+static unsigned char* pixelAddress(Image* image, int x, int y) {
+    return rowAddress(image, y) + (size_t)x * pixelBytes(image);
+}
+
+static const unsigned char* pixelAddress(const Image* image, int x, int y) {
+    return pixelAddress(const_cast<Image*>(image), x, y);
+}
+
+// Tipo MPI de un bloque de 'rows' filas por 'cols' píxeles dentro de una
+// imagen: un tramo contiguo por fila separado por el stride de la imagen
+static MPI_Datatype createBlockType(const Image* image, int rows, int cols) {
+    MPI_Datatype blockType;
+    MPI_Type_vector(rows, cols * pixelBytes(image), rowStride(image), MPI_BYTE, &blockType);
+    MPI_Type_commit(&blockType);
+    return blockType;
+}
+
+// Tipo MPI de una fila, para que los conteos de los mensajes sean filas y no
+// bytes: solo sus muestras, con extensión igual al stride para que 'n' filas
+// consecutivas sean 'n' elementos. El relleno de alineación no se transmite
+// (en los bloques creados sin inicializar nunca se escribe)
+static MPI_Datatype createRowType(const Image* image) {
+    MPI_Datatype samples, rowType;
+    MPI_Type_contiguous(image->getWidth() * pixelBytes(image), MPI_BYTE, &samples);
+    MPI_Type_create_resized(samples, 0, rowStride(image), &rowType);
+    MPI_Type_free(&samples);
+    MPI_Type_commit(&rowType);
+    return rowType;
+}
+
+Image* MPIFilter::createImage(int width, int height, int maxVal, const std::string& magicNumber) {
+    // Sin inicializar: todas las filas que se leen se reciben o se calculan antes
+    Image* image = nullptr;
+    if (magicNumber == "P2" || magicNumber == "P5") {
+        image = new PGMImage(width, height, maxVal, false);
+    } else if (magicNumber == "P3" || magicNumber == "P6") {
+        image = new PPMImage(width, height, maxVal, false);
+    }
+    if (image) {
+        image->setMagicNumber(magicNumber);
+    }
+    return image;
+}
+
+// Tamaño del buffer de una imagen del tipo indicado por el número mágico
+static size_t imageBufferBytes(int width, int height, int maxVal, const std::string& magicNumber) {
+    if (magicNumber == "P2" || magicNumber == "P5") {
+        return PGMImage::bufferBytes(width, height, maxVal);
+    }
+    return PPMImage::bufferBytes(width, height, maxVal);
+}
+
+// Imagen sobre un buffer externo (no se libera al borrarla)
+static Image* createImageView(int width, int height, int maxVal, const std::string& magicNumber,
+                              unsigned char* buffer) {
+    Image* image = nullptr;
+    if (magicNumber == "P2" || magicNumber == "P5") {
+        image = new PGMImage(width, height, maxVal, buffer);
+    } else if (magicNumber == "P3" || magicNumber == "P6") {
+        image = new PPMImage(width, height, maxVal, buffer);
+    }
+    if (image) {
+        image->setMagicNumber(magicNumber);
+    }
+    return image;
+}
+
+static unsigned char* alignPointer(unsigned char* p) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<unsigned char*>((address + PIXEL_ALIGNMENT - 1) & ~(uintptr_t)(PIXEL_ALIGNMENT - 1));
+}
+
+NodeWindow::NodeWindow(int width, int height, int maxVal, const std::string& magicNumber)
+    : leaderComm(MPI_COMM_NULL), nodeStart(0), nodeRows(0), firstRow(0), rowCount(0),
+      input(nullptr), output(nullptr) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
     
-    int width = input->getWidth();
-    int height = input->getHeight();
-    int maxVal = input->getMaxVal();
+    // Con la clave 'rank', el proceso 0 de MPI_COMM_WORLD es el 0 de su nodo
+    // y también el 0 entre los procesos 0 de cada nodo
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+    MPI_Comm_split(MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &leaderComm);
     
-    // Para simplificar, cada proceso procesa toda la imagen pero solo guarda su parte
-    Image* output = nullptr;
-    const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
-    const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
+    // Posición del primer proceso del nodo en la numeración nodo a nodo
+    int firstSlot = 0;
+    if (leaderComm != MPI_COMM_NULL) {
+        int leaderRank;
+        MPI_Comm_rank(leaderComm, &leaderRank);
+        MPI_Exscan(&nodeSize, &firstSlot, 1, MPI_INT, MPI_SUM, leaderComm);
+        if (leaderRank == 0) firstSlot = 0;   // MPI_Exscan no define el resultado del proceso 0
+    }
+    MPI_Bcast(&firstSlot, 1, MPI_INT, 0, nodeComm);
     
-    if (pgmInput) {
-        output = new PGMImage(width, height, maxVal);
-    } else if (ppmInput) {
-        output = new PPMImage(width, height, maxVal);
-    } else {
-        return nullptr;
+    RowDecomposition rows(height, size);
+    firstRow = rows.starts[firstSlot + nodeRank];
+    rowCount = rows.counts[firstSlot + nodeRank];
+    nodeStart = rows.starts[firstSlot];
+    for (int i = 0; i < nodeSize; i++) {
+        nodeRows += rows.counts[firstSlot + i];
     }
     
-    // Dividir trabajo entre procesos
-    int rowsPerProcess = height / size;
-    int startY = rank * rowsPerProcess;
-    int endY = (rank == size - 1) ? height : (rank + 1) * rowsPerProcess;
+    if (leaderComm != MPI_COMM_NULL) {
+        int leaders;
+        MPI_Comm_size(leaderComm, &leaders);
+        int range[2] = { nodeStart, nodeRows };
+        std::vector<int> ranges(2 * leaders);
+        MPI_Allgather(range, 2, MPI_INT, ranges.data(), 2, MPI_INT, leaderComm);
+        for (int i = 0; i < leaders; i++) {
+            nodeStarts.push_back(ranges[2 * i]);
+            nodeCounts.push_back(ranges[2 * i + 1]);
+        }
+    }
+    
+    // Entrada y salida en el segmento del proceso 0 del nodo, con margen para
+    // alinear los dos bloques
+    size_t bytes = imageBufferBytes(width, nodeRows + 2, maxVal, magicNumber);
+    MPI_Aint segment = nodeRank == 0 ? (MPI_Aint)(2 * (bytes + PIXEL_ALIGNMENT)) : 0;
+    unsigned char* base = nullptr;
+    MPI_Win_allocate_shared(segment, 1, MPI_INFO_NULL, nodeComm, &base, &window);
+    MPI_Aint segmentSize;
+    int dispUnit;
+    MPI_Win_shared_query(window, 0, &segmentSize, &dispUnit, &base);
+    input = alignPointer(base);
+    output = alignPointer(input + bytes);
+    
+    // Época de acceso pasiva durante toda la vida de la ventana: las
+    // escrituras se publican con synchronize()
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+}
+
+NodeWindow::~NodeWindow() {
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
+    if (leaderComm != MPI_COMM_NULL) {
+        MPI_Comm_free(&leaderComm);
+    }
+    MPI_Comm_free(&nodeComm);
+}
+
+void NodeWindow::synchronize() {
+    MPI_Win_sync(window);
+    MPI_Barrier(nodeComm);
+    MPI_Win_sync(window);
+}
+
+Image* MPIFilter::distributeImage(const Image* image, int width, int height, int maxVal,
+                                  const std::string& magicNumber, int rank, int size) {
+    RowDecomposition rows(height, size);
     
     if (rank == 0) {
         std::cout << "Distribuyendo trabajo entre " << size << " procesos MPI:" << std::endl;
         for (int i = 0; i < size; i++) {
-            int start = i * rowsPerProcess;
-            int end = (i == size - 1) ? height : (i + 1) * rowsPerProcess;
-            std::cout << "  Proceso " << i << ": filas " << start << " a " << end << std::endl;
+            std::cout << "  Proceso " << i << ": filas " << rows.starts[i] << " a "
+                      << rows.starts[i] + rows.counts[i] << std::endl;
         }
     }
     
-    std::cout << "Proceso " << rank << " procesando filas " << startY << " a " << endY << std::endl;
+    // Bloque local: filas propias más un halo arriba y otro abajo
+    Image* local = createImage(width, rows.counts[rank] + 2, maxVal, magicNumber);
+    if (!local) return nullptr;
+    
+    MPI_Datatype rowType = createRowType(local);
+    MPI_Scatterv(rank == 0 ? rowAddress(image, 0) : nullptr, rows.counts.data(), rows.starts.data(), rowType,
+                 rowAddress(local, 1), rows.counts[rank], rowType, 0, MPI_COMM_WORLD);
+    MPI_Type_free(&rowType);
+    return local;
+}
+
+// Vecinos de un proceso con filas. Los procesos con filas son siempre los
+// primeros, así que un vecino inferior sin filas equivale a estar en el borde
+// de la imagen
+static void haloNeighbours(const RowDecomposition& rows, int rank, int& up, int& down) {
+    int size = (int)rows.counts.size();
+    up = rank > 0 ? rank - 1 : MPI_PROC_NULL;
+    down = (rank + 1 < size && rows.counts[rank + 1] > 0) ? rank + 1 : MPI_PROC_NULL;
+}
+
+// Intercambio bloqueante de las filas de halo de un bloque de 'count' filas
+// propias con los vecinos 'up' y 'down' de 'comm'
+static void sendrecvHalos(Image* block, int count, int up, int down, MPI_Comm comm) {
+    MPI_Datatype rowType = createRowType(block);
+    // Primera fila propia hacia arriba, halo inferior desde abajo
+    MPI_Sendrecv(rowAddress(block, 1), 1, rowType, up, TAG_ROWS,
+                 rowAddress(block, count + 1), 1, rowType, down, TAG_ROWS,
+                 comm, MPI_STATUS_IGNORE);
+    // Última fila propia hacia abajo, halo superior desde arriba
+    MPI_Sendrecv(rowAddress(block, count), 1, rowType, down, TAG_ROWS,
+                 rowAddress(block, 0), 1, rowType, up, TAG_ROWS,
+                 comm, MPI_STATUS_IGNORE);
+    MPI_Type_free(&rowType);
+}
+
+void MPIFilter::exchangeHalos(Image* localBlock, int height, int rank, int size) {
+    RowDecomposition rows(height, size);
+    int count = rows.counts[rank];
+    if (count == 0) return;
+    
+    int up, down;
+    haloNeighbours(rows, rank, up, down);
+    sendrecvHalos(localBlock, count, up, down, MPI_COMM_WORLD);
+    
+    // Bordes de la imagen: el filtro replica la fila del extremo
+    if (up == MPI_PROC_NULL) copyRegion(localBlock, localBlock, 1, 0, 1);
+    if (down == MPI_PROC_NULL) copyRegion(localBlock, localBlock, count, count + 1, 1);
+}
+
+void MPIFilter::startHaloExchange(Image* localBlock, int height, int rank, int size,
+                                  MPI_Datatype rowType, MPI_Request requests[4]) {
+    RowDecomposition rows(height, size);
+    int count = rows.counts[rank];
+    int up, down;
+    haloNeighbours(rows, rank, up, down);
     
-    // Aplicar filtro secuencialmente a toda la imagen
-    processRegion(input, output, filter, 0, height);
+    // Con MPI_PROC_NULL las operaciones terminan de inmediato
+    MPI_Irecv(rowAddress(localBlock, 0), 1, rowType, up, TAG_ROWS, MPI_COMM_WORLD, &requests[0]);
+    MPI_Irecv(rowAddress(localBlock, count + 1), 1, rowType, down, TAG_ROWS, MPI_COMM_WORLD, &requests[1]);
+    MPI_Isend(rowAddress(localBlock, 1), 1, rowType, up, TAG_ROWS, MPI_COMM_WORLD, &requests[2]);
+    MPI_Isend(rowAddress(localBlock, count), 1, rowType, down, TAG_ROWS, MPI_COMM_WORLD, &requests[3]);
     
+    if (up == MPI_PROC_NULL) copyRegion(localBlock, localBlock, 1, 0, 1);
+    if (down == MPI_PROC_NULL) copyRegion(localBlock, localBlock, count, count + 1, 1);
+}
+
+Image* MPIFilter::applyFilterDistributed(Image* localBlock, Filter* filter, int height,
+                                         int rank, int size) {
+    if (!localBlock || !filter) return nullptr;
+    
+    RowDecomposition rows(height, size);
+    int count = rows.counts[rank];
+    std::cout << "Proceso " << rank << " procesando filas " << rows.starts[rank] << " a "
+              << rows.starts[rank] + count;
+    if (threads > 1) std::cout << " con " << threads << " hilos";
+    std::cout << std::endl;
+    
+    Image* output = createImage(localBlock->getWidth(), localBlock->getHeight(),
+                                localBlock->getMaxVal(), localBlock->getMagicNumber());
+    if (!output) return nullptr;
+    
+    if (iterations > 1) {
+        return applyFilterIterated(localBlock, output, filter, height, rank, size);
+    }
+    
+    if (overlap && count > 2) {
+        // Las filas 2..count-1 solo dependen de filas propias: se filtran
+        // mientras llegan los halos
+        MPI_Datatype rowType = createRowType(localBlock);
+        MPI_Request requests[4];
+        startHaloExchange(localBlock, height, rank, size, rowType, requests);
+        processRegion(localBlock, output, filter, 2, count);
+        MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+        MPI_Type_free(&rowType);
+        
+        processRegion(localBlock, output, filter, 1, 2);
+        processRegion(localBlock, output, filter, count, count + 1);
+    } else {
+        exchangeHalos(localBlock, height, rank, size);
+        
+        // Solo las filas propias; los halos aportan las filas vecinas
+        processRegion(localBlock, output, filter, 1, count + 1);
+    }
+    return output;
+}
+
+Image* MPIFilter::filterImage(const Image* image, Filter* filter) {
+    if (!image || !filter) return nullptr;
+    
+    Image* output = createImage(image->getWidth(), image->getHeight(), image->getMaxVal(),
+                                image->getMagicNumber());
+    if (output) {
+        processRegion(image, output, filter, 0, image->getHeight());
+    }
+    return output;
+}
+
+Image* MPIFilter::applyFilterIterated(Image* localBlock, Image* output, Filter* filter, int height,
+                                      int rank, int size) {
+    RowDecomposition rows(height, size);
+    int count = rows.counts[rank];
+    if (count == 0) return output;
+    
+    int up, down;
+    haloNeighbours(rows, rank, up, down);
+    
+    // Doble buffer: la pasada i lee buffers[i % 2] y escribe en el otro. Cada
+    // buffer tiene sus propias solicitudes persistentes, creadas una vez
+    Image* buffers[2] = { localBlock, output };
+    MPI_Datatype rowType = createRowType(localBlock);
+    MPI_Request requests[2][4];
+    for (int b = 0; b < 2; b++) {
+        MPI_Recv_init(rowAddress(buffers[b], 0), 1, rowType, up, TAG_ROWS, MPI_COMM_WORLD, &requests[b][0]);
+        MPI_Recv_init(rowAddress(buffers[b], count + 1), 1, rowType, down, TAG_ROWS, MPI_COMM_WORLD,
+                      &requests[b][1]);
+        MPI_Send_init(rowAddress(buffers[b], 1), 1, rowType, up, TAG_ROWS, MPI_COMM_WORLD, &requests[b][2]);
+        MPI_Send_init(rowAddress(buffers[b], count), 1, rowType, down, TAG_ROWS, MPI_COMM_WORLD,
+                      &requests[b][3]);
+    }
+    
+    for (int i = 0; i < iterations; i++) {
+        Image* input = buffers[i % 2];
+        Image* result = buffers[(i + 1) % 2];
+        
+        MPI_Startall(4, requests[i % 2]);
+        if (up == MPI_PROC_NULL) copyRegion(input, input, 1, 0, 1);
+        if (down == MPI_PROC_NULL) copyRegion(input, input, count, count + 1, 1);
+        
+        if (overlap && count > 2) {
+            processRegion(input, result, filter, 2, count);
+            MPI_Waitall(4, requests[i % 2], MPI_STATUSES_IGNORE);
+            processRegion(input, result, filter, 1, 2);
+            processRegion(input, result, filter, count, count + 1);
+        } else {
+            MPI_Waitall(4, requests[i % 2], MPI_STATUSES_IGNORE);
+            processRegion(input, result, filter, 1, count + 1);
+        }
+    }
+    
+    for (int b = 0; b < 2; b++) {
+        for (int r = 0; r < 4; r++) {
+            MPI_Request_free(&requests[b][r]);
+        }
+    }
+    MPI_Type_free(&rowType);
+    
+    // Con un número par de pasadas el resultado quedó en el bloque local
+    if (iterations % 2 == 0) {
+        copyRegion(localBlock, output, 1, 1, count);
+    }
     return output;
 }
 
-// Las demás funciones permanecen igual pero simplificadas
 void MPIFilter::processRegion(const Image* input, Image* output, Filter* filter,
-                             int startY, int endY) {
-    const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
-    const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
-    PGMImage* pgmOutput = dynamic_cast<PGMImage*>(output);
-    PPMImage* ppmOutput = dynamic_cast<PPMImage*>(output);
-    
-    double kernel[3][3];
-    bool isLaplacian = false;
-    
-    if (strcmp(filter->getName(), "Blur") == 0) {
-        double blurKernel[3][3] = {
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0}
-        };
-        memcpy(kernel, blurKernel, sizeof(kernel));
-    } else if (strcmp(filter->getName(), "Laplacian") == 0) {
-        double laplacianKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  4, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, laplacianKernel, sizeof(kernel));
-        isLaplacian = true;
-    } else if (strcmp(filter->getName(), "Sharpen") == 0) {
-        double sharpenKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  5, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, sharpenKernel, sizeof(kernel));
-    }
-    
-    int width = input->getWidth();
-    int height = input->getHeight();
-    int maxVal = input->getMaxVal();
-    
-    // Procesar toda la imagen (simplificado para que funcione)
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (pgmInput && pgmOutput) {
-                double sum = 0;
-                
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        if (px < 0) px = 0;
-                        if (px >= width) px = width - 1;
-                        if (py < 0) py = 0;
-                        if (py >= height) py = height - 1;
-                        
-                        int pixel = pgmInput->getPixel(px, py);
-                        sum += pixel * kernel[ky + 1][kx + 1];
-                    }
-                }
-                
-                int result = (int)std::round(sum);
-                if (isLaplacian) {
-                    result += 128;
-                }
-                result = std::max(0, std::min(maxVal, result));
-                pgmOutput->setPixel(x, y, result);
-                
-            } else if (ppmInput && ppmOutput) {
-                double sumR = 0, sumG = 0, sumB = 0;
-                
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        if (px < 0) px = 0;
-                        if (px >= width) px = width - 1;
-                        if (py < 0) py = 0;
-                        if (py >= height) py = height - 1;
-                        
-                        RGB pixel = ppmInput->getPixel(px, py);
-                        double kernelValue = kernel[ky + 1][kx + 1];
-                        
-                        sumR += pixel.r * kernelValue;
-                        sumG += pixel.g * kernelValue;
-                        sumB += pixel.b * kernelValue;
-                    }
-                }
-                
-                int r = (int)std::round(sumR);
-                int g = (int)std::round(sumG);
-                int b = (int)std::round(sumB);
-                
-                if (isLaplacian) {
-                    r += 128;
-                    g += 128;
-                    b += 128;
-                }
-                
-                r = std::max(0, std::min(maxVal, r));
-                g = std::max(0, std::min(maxVal, g));
-                b = std::max(0, std::min(maxVal, b));
-                
-                ppmOutput->setPixel(x, y, RGB(r, g, b));
-            }
+                              int startY, int endY) {
+    // Determinar el kernel según el tipo de filtro (aritmética entera si el kernel lo permite)
+    Kernel3x3 kernel;
+    if (!getFilterKernel(filter->getName(), kernel)) {
+        return;
+    }
+    
+    if (threads > 1) {
+        OMPFilter::filterRows(input, output, kernel, startY, endY);
+    } else {
+        convolveRegion(input, output, kernel, 0, input->getWidth(), startY, endY);
+    }
+}
+
+void MPIFilter::copyRegion(const Image* source, Image* dest, int srcStartY, int destStartY, int rows) {
+    if (rows <= 0) return;
+    // Mismo tipo, ancho y maxVal: filas del mismo tamaño y separación
+    memmove(rowAddress(dest, destStartY), rowAddress(source, srcStartY), (size_t)rowStride(source) * rows);
+}
+
+bool MPIFilter::probeBinaryImage(const std::string& filename, ImageHeader& header) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    parseImageHeader(file.data(), file.size(), header);
+    
+    bool gray = header.magicNumber == "P5";
+    if (!gray && header.magicNumber != "P6") return false;
+    if (header.width <= 0 || header.height <= 0) return false;
+    if (header.maxVal <= 0 || header.maxVal > MAX_SAMPLE_VALUE) return false;
+    
+    // Los archivos truncados se cargan en el proceso 0 para informar del error
+    size_t rowBytes = (size_t)header.width * (gray ? 1 : 3) * Image::sampleSizeFor(header.maxVal);
+    return header.dataOffset <= file.size() &&
+           (file.size() - header.dataOffset) / rowBytes >= (size_t)header.height;
+}
+
+// Bytes de una fila en el archivo binario (sin relleno; 2 bytes por muestra si maxVal > 255)
+static size_t fileRowBytes(const Image* image) {
+    int channels = dynamic_cast<const PPMImage*>(image) ? 3 : 1;
+    return (size_t)image->getWidth() * channels * image->getSampleSize();
+}
+
+Image* MPIFilter::readImageParallel(const std::string& filename, const ImageHeader& header,
+                                    int rank, int size) {
+    RowDecomposition rows(header.height, size);
+    int count = rows.counts[rank];
+    Image* local = createImage(header.width, count + 2, header.maxVal, header.magicNumber);
+    if (!local) return nullptr;
+    
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        if (rank == 0) std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
+        delete local;
+        return nullptr;
+    }
+    
+    // Lectura colectiva de las filas propias tal como están en el archivo
+    size_t rowBytes = fileRowBytes(local);
+    std::vector<char> buffer(rowBytes * count);
+    MPI_Datatype fileRow;
+    MPI_Type_contiguous((int)rowBytes, MPI_BYTE, &fileRow);
+    MPI_Type_commit(&fileRow);
+    MPI_Offset offset = (MPI_Offset)header.dataOffset + (MPI_Offset)rows.starts[rank] * (MPI_Offset)rowBytes;
+    int result = MPI_File_read_at_all(file, offset, buffer.data(), count, fileRow, MPI_STATUS_IGNORE);
+    MPI_Type_free(&fileRow);
+    MPI_File_close(&file);
+    
+    if (result != MPI_SUCCESS) {
+        std::cerr << "Proceso " << rank << ": Error al leer " << filename << std::endl;
+        delete local;
+        return nullptr;
+    }
+    
+    // Decodificar cada fila (big-endian y saturación a maxVal) en el bloque
+    size_t samplesPerRow = rowBytes / local->getSampleSize();
+    for (int i = 0; i < count; i++) {
+        const char* src = buffer.data() + (size_t)i * rowBytes;
+        if (local->getSampleSize() == 1) {
+            decodeBinarySamples(src, rowAddress(local, i + 1), samplesPerRow, header.maxVal);
+        } else {
+            decodeBinarySamples(src, reinterpret_cast<uint16_t*>(rowAddress(local, i + 1)), samplesPerRow,
+                                header.maxVal);
         }
     }
+    return local;
 }
 
-void MPIFilter::distributeImage(const Image* image, int rank, int size) {
+bool MPIFilter::writeImageParallel(const std::string& filename, const Image* localResult, int height,
+                                   int rank, int size) {
+    RowDecomposition rows(height, size);
+    int count = rows.counts[rank];
+    std::string magic = localResult->getMagicNumber();
+    std::string header = magic == "P5"
+        ? PGMImage::formatHeader(magic, localResult->getWidth(), height, localResult->getMaxVal())
+        : PPMImage::formatHeader(magic, localResult->getWidth(), height, localResult->getMaxVal());
+    
+    // Codificar las filas propias tal como van en el archivo
+    size_t rowBytes = fileRowBytes(localResult);
+    size_t samplesPerRow = rowBytes / localResult->getSampleSize();
+    std::vector<char> buffer(rowBytes * count);
+    for (int i = 0; i < count; i++) {
+        char* dst = buffer.data() + (size_t)i * rowBytes;
+        const unsigned char* src = rowAddress(localResult, i + 1);
+        if (localResult->getSampleSize() == 1) {
+            memcpy(dst, src, rowBytes);
+        } else {
+            encodeBinarySamples(reinterpret_cast<const uint16_t*>(src), samplesPerRow, dst);
+        }
+    }
+    
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &file) != MPI_SUCCESS) {
+        if (rank == 0) std::cerr << "Error: No se pudo crear el archivo " << filename << std::endl;
+        return false;
+    }
+    
+    // Tamaño exacto: MPI_MODE_CREATE no trunca un archivo existente
+    MPI_Offset dataOffset = (MPI_Offset)header.size();
+    int ok = MPI_File_set_size(file, dataOffset + (MPI_Offset)height * (MPI_Offset)rowBytes) == MPI_SUCCESS;
     if (rank == 0) {
-        std::cout << "Distribuyendo imagen entre " << size << " procesos..." << std::endl;
+        ok &= MPI_File_write_at(file, 0, header.data(), (int)header.size(), MPI_CHAR,
+                                MPI_STATUS_IGNORE) == MPI_SUCCESS;
     }
-    MPI_Barrier(MPI_COMM_WORLD);
+    
+    MPI_Datatype fileRow;
+    MPI_Type_contiguous((int)rowBytes, MPI_BYTE, &fileRow);
+    MPI_Type_commit(&fileRow);
+    MPI_Offset offset = dataOffset + (MPI_Offset)rows.starts[rank] * (MPI_Offset)rowBytes;
+    ok &= MPI_File_write_at_all(file, offset, buffer.data(), count, fileRow, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    MPI_Type_free(&fileRow);
+    ok &= MPI_File_close(&file) == MPI_SUCCESS;
+    
+    // Todos los procesos devuelven el mismo resultado
+    int allOk = 0;
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (!allOk && rank == 0) {
+        std::cerr << "Error: No se pudo escribir el archivo " << filename << std::endl;
+    }
+    return allOk != 0;
 }
 
-Image* MPIFilter::gatherImage(const Image* localResult, int width, int height, int maxVal, 
-                             const std::string& magicNumber, int rank, int size) {
-    if (rank == 0) {
-        std::cout << "Recopilando resultados de " << size << " procesos..." << std::endl;
-        // Para simplificar, el proceso 0 ya tiene la imagen completa
-        Image* result = nullptr;
-        if (magicNumber == "P2") {
-            result = new PGMImage(width, height, maxVal);
-        } else if (magicNumber == "P3") {
-            result = new PPMImage(width, height, maxVal);
+bool MPIFilter::probeAsciiImage(const std::string& filename, ImageHeader& header) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    parseImageHeader(file.data(), file.size(), header);
+    
+    return (header.magicNumber == "P2" || header.magicNumber == "P3") &&
+           header.width > 0 && header.height > 0 &&
+           header.maxVal > 0 && header.maxVal <= MAX_SAMPLE_VALUE;
+}
+
+Image* MPIFilter::readAsciiParallel(const std::string& filename, const ImageHeader& header,
+                                    int rank, int size) {
+    RowDecomposition rows(header.height, size);
+    int count = rows.counts[rank];
+    Image* local = createImage(header.width, count + 2, header.maxVal, header.magicNumber);
+    if (!local) return nullptr;
+    
+    MappedFile file;
+    int failed = file.open(filename) ? 0 : 1;
+    const char* data = file.data() + (failed ? 0 : header.dataOffset);
+    const char* end = file.data() + file.size();
+    if (data > end) data = end;
+    
+    // Tramo de bytes de este proceso: partes iguales de la sección de
+    // píxeles, con cada frontera movida hasta un espacio (como en
+    // readSamplesParallel), así ningún token queda repartido entre dos tramos
+    unsigned long long length = (unsigned long long)(end - data);
+    const char* begin = rank == 0 ? data : nextSpace(data + length * rank / size, end);
+    const char* stop = rank == size - 1 ? end : nextSpace(data + length * (rank + 1) / size, end);
+    
+    // Índice global del primer token de cada tramo. countTokens y skipTokens
+    // separan los tokens como TextScanner::readSamples, así que hasta el
+    // primer token inválido los índices coinciden con la lectura secuencial y
+    // el proceso cuyas filas lo contienen lo encuentra y falla
+    unsigned long long chunk[3] = { 0, countTokens(begin, stop), (unsigned long long)(begin - data) };
+    MPI_Exscan(&chunk[1], &chunk[0], 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) chunk[0] = 0;   // MPI_Exscan no define el resultado del proceso 0
+    std::vector<unsigned long long> chunks(3 * size);
+    MPI_Allgather(chunk, 3, MPI_UNSIGNED_LONG_LONG, chunks.data(), 3, MPI_UNSIGNED_LONG_LONG, MPI_COMM_WORLD);
+    
+    size_t samplesPerRow = (size_t)header.width * (header.magicNumber == "P3" ? 3 : 1);
+    unsigned long long totalTokens = chunks[3 * (size - 1)] + chunks[3 * (size - 1) + 1];
+    if (totalTokens < (unsigned long long)samplesPerRow * header.height) failed = 1;
+    
+    // Filas a decodificar: las propias más los halos que existen en la imagen
+    int firstRow = std::max(0, rows.starts[rank] - 1);
+    int lastRow = std::min(header.height, rows.starts[rank] + count + 1);
+    if (!failed && count > 0) {
+        // Tramo que contiene la primera muestra y salto de los tokens previos
+        unsigned long long firstSample = (unsigned long long)firstRow * samplesPerRow;
+        int owner = 0;
+        for (int i = 0; i < size; i++) {
+            if (chunks[3 * i] <= firstSample && chunks[3 * i + 1] > 0) owner = i;
         }
+        const char* p = skipTokens(data + chunks[3 * owner + 2], end, (size_t)(firstSample - chunks[3 * owner]));
         
-        // Copiar toda la imagen del proceso 0
-        const PGMImage* pgmLocal = dynamic_cast<const PGMImage*>(localResult);
-        const PPMImage* ppmLocal = dynamic_cast<const PPMImage*>(localResult);
-        PGMImage* pgmResult = dynamic_cast<PGMImage*>(result);
-        PPMImage* ppmResult = dynamic_cast<PPMImage*>(result);
-        
-        if (pgmLocal && pgmResult) {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    pgmResult->setPixel(x, y, pgmLocal->getPixel(x, y));
-                }
-            }
-        } else if (ppmLocal && ppmResult) {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    ppmResult->setPixel(x, y, ppmLocal->getPixel(x, y));
-                }
-            }
+        TextScanner scanner(p, end);
+        int localRow = firstRow - (rows.starts[rank] - 1);
+        for (int y = firstRow; y < lastRow && !failed; y++, localRow++) {
+            size_t read = local->getSampleSize() == 1
+                ? scanner.readSamples(rowAddress(local, localRow), samplesPerRow, header.maxVal)
+                : scanner.readSamples(reinterpret_cast<uint16_t*>(rowAddress(local, localRow)), samplesPerRow,
+                                      header.maxVal);
+            failed = read < samplesPerRow ? 1 : 0;
         }
-        
-        MPI_Barrier(MPI_COMM_WORLD);
-        return result;
-    } else {
-        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    
+    // Todos los procesos devuelven lo mismo
+    int anyFailed = 0;
+    MPI_Allreduce(&failed, &anyFailed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (anyFailed) {
+        delete local;
         return nullptr;
     }
+    return local;
+}
+
+MPI_Comm MPIFilter::createGrid(const BlockDecomposition& blocks) {
+    int dims[2] = { blocks.dims[0], blocks.dims[1] };
+    int periods[2] = { 0, 0 };
+    MPI_Comm grid;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid);
+    return grid;
+}
+
+Image* MPIFilter::distributeBlocks(const Image* image, int maxVal, const std::string& magicNumber,
+                                   const BlockDecomposition& blocks, MPI_Comm grid) {
+    int rank, size;
+    MPI_Comm_rank(grid, &rank);
+    MPI_Comm_size(grid, &size);
+    
+    if (rank == 0) {
+        std::cout << "Distribuyendo bloques en una malla de " << blocks.dims[0] << " x " << blocks.dims[1]
+                  << " procesos MPI:" << std::endl;
+    }
+    
+    // El proceso 0 envía cada bloque directamente desde la imagen completa
+    std::vector<MPI_Request> requests;
+    std::vector<MPI_Datatype> types;
+    requests.reserve(size);
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            int coords[2];
+            MPI_Cart_coords(grid, r, 2, coords);
+            int rows = blocks.rows.counts[coords[0]];
+            int cols = blocks.cols.counts[coords[1]];
+            int startY = blocks.rows.starts[coords[0]];
+            int startX = blocks.cols.starts[coords[1]];
+            std::cout << "  Proceso " << r << ": filas " << startY << " a " << startY + rows
+                      << ", columnas " << startX << " a " << startX + cols << std::endl;
+            if (rows == 0 || cols == 0) continue;
+            
+            types.push_back(createBlockType(image, rows, cols));
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(pixelAddress(image, startX, startY), 1, types.back(), r, TAG_ROWS, grid, &requests.back());
+        }
+    }
+    
+    int coords[2];
+    MPI_Cart_coords(grid, rank, 2, coords);
+    int rows = blocks.rows.counts[coords[0]];
+    int cols = blocks.cols.counts[coords[1]];
+    Image* local = createImage(cols + 2, rows + 2, maxVal, magicNumber);
+    if (local && rows > 0 && cols > 0) {
+        MPI_Datatype blockType = createBlockType(local, rows, cols);
+        MPI_Recv(pixelAddress(local, 1, 1), 1, blockType, 0, TAG_ROWS, grid, MPI_STATUS_IGNORE);
+        MPI_Type_free(&blockType);
+    }
+    
+    MPI_Waitall((int)requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    for (size_t i = 0; i < types.size(); i++) {
+        MPI_Type_free(&types[i]);
+    }
+    return local;
+}
+
+// Copia la columna srcX en destX para las filas 1..rows
+static void copyColumn(Image* image, int srcX, int destX, int rows) {
+    size_t bytes = pixelBytes(image);
+    for (int y = 1; y <= rows; y++) {
+        memcpy(pixelAddress(image, destX, y), pixelAddress(image, srcX, y), bytes);
+    }
+}
+
+void MPIFilter::exchangeBlockHalos(Image* localBlock, const BlockDecomposition& blocks, MPI_Comm grid) {
+    int rank;
+    MPI_Comm_rank(grid, &rank);
+    int coords[2];
+    MPI_Cart_coords(grid, rank, 2, coords);
+    int rows = blocks.rows.counts[coords[0]];
+    int cols = blocks.cols.counts[coords[1]];
+    if (rows == 0 || cols == 0) return;
+    
+    int up, down, left, right;
+    MPI_Cart_shift(grid, 0, 1, &up, &down);
+    MPI_Cart_shift(grid, 1, 1, &left, &right);
+    // Los bloques vacíos están al final de cada eje: equivalen al borde
+    if (down != MPI_PROC_NULL && blocks.rows.counts[coords[0] + 1] == 0) down = MPI_PROC_NULL;
+    if (right != MPI_PROC_NULL && blocks.cols.counts[coords[1] + 1] == 0) right = MPI_PROC_NULL;
+    
+    // Columnas: un píxel por fila propia, separados por el stride del bloque
+    MPI_Datatype columnType = createBlockType(localBlock, rows, 1);
+    MPI_Sendrecv(pixelAddress(localBlock, 1, 1), 1, columnType, left, TAG_ROWS,
+                 pixelAddress(localBlock, cols + 1, 1), 1, columnType, right, TAG_ROWS,
+                 grid, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(pixelAddress(localBlock, cols, 1), 1, columnType, right, TAG_ROWS,
+                 pixelAddress(localBlock, 0, 1), 1, columnType, left, TAG_ROWS,
+                 grid, MPI_STATUS_IGNORE);
+    MPI_Type_free(&columnType);
+    if (left == MPI_PROC_NULL) copyColumn(localBlock, 1, 0, rows);
+    if (right == MPI_PROC_NULL) copyColumn(localBlock, cols, cols + 1, rows);
+    
+    // Filas completas, con las columnas de halo ya actualizadas
+    MPI_Datatype rowType = createRowType(localBlock);
+    MPI_Sendrecv(rowAddress(localBlock, 1), 1, rowType, up, TAG_ROWS,
+                 rowAddress(localBlock, rows + 1), 1, rowType, down, TAG_ROWS,
+                 grid, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(rowAddress(localBlock, rows), 1, rowType, down, TAG_ROWS,
+                 rowAddress(localBlock, 0), 1, rowType, up, TAG_ROWS,
+                 grid, MPI_STATUS_IGNORE);
+    MPI_Type_free(&rowType);
+    if (up == MPI_PROC_NULL) copyRegion(localBlock, localBlock, 1, 0, 1);
+    if (down == MPI_PROC_NULL) copyRegion(localBlock, localBlock, rows, rows + 1, 1);
+}
+
+Image* MPIFilter::applyFilterBlocks(Image* localBlock, Filter* filter, const BlockDecomposition& blocks,
+                                    MPI_Comm grid) {
+    if (!localBlock || !filter) return nullptr;
+    
+    int rank;
+    MPI_Comm_rank(grid, &rank);
+    int coords[2];
+    MPI_Cart_coords(grid, rank, 2, coords);
+    int rows = blocks.rows.counts[coords[0]];
+    int cols = blocks.cols.counts[coords[1]];
+    int startY = blocks.rows.starts[coords[0]];
+    int startX = blocks.cols.starts[coords[1]];
+    std::cout << "Proceso " << rank << " (" << coords[0] << ", " << coords[1] << ") procesando filas "
+              << startY << " a " << startY + rows << ", columnas " << startX << " a " << startX + cols;
+    if (threads > 1) std::cout << " con " << threads << " hilos";
+    std::cout << std::endl;
+    
+    Image* output = createImage(localBlock->getWidth(), localBlock->getHeight(),
+                                localBlock->getMaxVal(), localBlock->getMagicNumber());
+    if (!output) return nullptr;
+    
+    exchangeBlockHalos(localBlock, blocks, grid);
+    
+    // Filas propias con todo el ancho local: las dos columnas de halo también
+    // se calculan, pero no se recopilan
+    if (rows > 0 && cols > 0) {
+        processRegion(localBlock, output, filter, 1, rows + 1);
+    }
+    return output;
+}
+
+Image* MPIFilter::gatherBlocks(const Image* localResult, int width, int height, int maxVal,
+                               const std::string& magicNumber, const BlockDecomposition& blocks,
+                               MPI_Comm grid) {
+    int rank, size;
+    MPI_Comm_rank(grid, &rank);
+    MPI_Comm_size(grid, &size);
+    Image* result = nullptr;
+    
+    // El proceso 0 recibe cada bloque directamente en su posición final
+    std::vector<MPI_Request> requests;
+    std::vector<MPI_Datatype> types;
+    requests.reserve(size);
+    if (rank == 0) {
+        std::cout << "Recopilando bloques de " << size << " procesos..." << std::endl;
+        result = createImage(width, height, maxVal, magicNumber);
+        for (int r = 0; r < size; r++) {
+            int coords[2];
+            MPI_Cart_coords(grid, r, 2, coords);
+            int rows = blocks.rows.counts[coords[0]];
+            int cols = blocks.cols.counts[coords[1]];
+            if (rows == 0 || cols == 0) continue;
+            
+            types.push_back(createBlockType(result, rows, cols));
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Irecv(pixelAddress(result, blocks.cols.starts[coords[1]], blocks.rows.starts[coords[0]]), 1,
+                      types.back(), r, TAG_ROWS, grid, &requests.back());
+        }
+    }
+    
+    int coords[2];
+    MPI_Cart_coords(grid, rank, 2, coords);
+    int rows = blocks.rows.counts[coords[0]];
+    int cols = blocks.cols.counts[coords[1]];
+    if (rows > 0 && cols > 0) {
+        MPI_Datatype blockType = createBlockType(localResult, rows, cols);
+        MPI_Send(pixelAddress(localResult, 1, 1), 1, blockType, 0, TAG_ROWS, grid);
+        MPI_Type_free(&blockType);
+    }
+    
+    MPI_Waitall((int)requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    for (size_t i = 0; i < types.size(); i++) {
+        MPI_Type_free(&types[i]);
+    }
+    return result;
+}
+
+Image* MPIFilter::distributeShared(const Image* image, int width, int maxVal, const std::string& magicNumber,
+                                   NodeWindow& node) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    if (rank == 0) {
+        std::cout << "Distribuyendo trabajo entre " << node.nodeCounts.size()
+                  << " nodos (memoria compartida):" << std::endl;
+        for (size_t i = 0; i < node.nodeCounts.size(); i++) {
+            std::cout << "  Nodo " << i << ": filas " << node.nodeStarts[i] << " a "
+                      << node.nodeStarts[i] + node.nodeCounts[i] << std::endl;
+        }
+    }
+    
+    // Bloque del nodo: sus filas más un halo arriba y otro abajo
+    Image* block = createImageView(width, node.nodeRows + 2, maxVal, magicNumber, node.input);
+    if (!block) return nullptr;
+    
+    // Solo un mensaje por nodo: los demás procesos leen la ventana
+    if (node.isLeader()) {
+        MPI_Datatype rowType = createRowType(block);
+        MPI_Scatterv(rank == 0 ? rowAddress(image, 0) : nullptr, node.nodeCounts.data(), node.nodeStarts.data(),
+                     rowType, rowAddress(block, 1), node.nodeRows, rowType, 0, node.leaderComm);
+        MPI_Type_free(&rowType);
+    }
+    return block;
+}
+
+void MPIFilter::exchangeNodeHalos(Image* nodeBlock, const NodeWindow& node) {
+    if (!node.isLeader() || node.nodeRows == 0) return;
+    
+    // Los nodos sin filas están al final: equivalen al borde de la imagen
+    int leaderRank, leaders;
+    MPI_Comm_rank(node.leaderComm, &leaderRank);
+    MPI_Comm_size(node.leaderComm, &leaders);
+    int up = leaderRank > 0 ? leaderRank - 1 : MPI_PROC_NULL;
+    int down = (leaderRank + 1 < leaders && node.nodeCounts[leaderRank + 1] > 0) ? leaderRank + 1 : MPI_PROC_NULL;
+    sendrecvHalos(nodeBlock, node.nodeRows, up, down, node.leaderComm);
+    
+    if (up == MPI_PROC_NULL) copyRegion(nodeBlock, nodeBlock, 1, 0, 1);
+    if (down == MPI_PROC_NULL) copyRegion(nodeBlock, nodeBlock, node.nodeRows, node.nodeRows + 1, 1);
+}
+
+Image* MPIFilter::applyFilterShared(Image* nodeBlock, Filter* filter, NodeWindow& node) {
+    if (!nodeBlock || !filter) return nullptr;
+    
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::cout << "Proceso " << rank << " procesando filas " << node.firstRow << " a "
+              << node.firstRow + node.rowCount;
+    if (threads > 1) std::cout << " con " << threads << " hilos";
+    std::cout << std::endl;
+    
+    Image* output = createImageView(nodeBlock->getWidth(), nodeBlock->getHeight(), nodeBlock->getMaxVal(),
+                                    nodeBlock->getMagicNumber(), node.output);
+    if (!output) return nullptr;
+    
+    // Halos entre nodos; dentro del nodo las filas vecinas ya están en la ventana
+    exchangeNodeHalos(nodeBlock, node);
+    node.synchronize();
+    
+    if (node.rowCount > 0) {
+        int startY = 1 + node.firstRow - node.nodeStart;
+        processRegion(nodeBlock, output, filter, startY, startY + node.rowCount);
+    }
+    
+    // La salida del nodo completa antes de recopilarla
+    node.synchronize();
+    return output;
+}
+
+Image* MPIFilter::gatherShared(const Image* nodeResult, int width, int height, int maxVal,
+                               const std::string& magicNumber, NodeWindow& node) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    Image* result = nullptr;
+    
+    if (rank == 0) {
+        std::cout << "Recopilando resultados de " << node.nodeCounts.size() << " nodos..." << std::endl;
+        result = createImage(width, height, maxVal, magicNumber);
+    }
+    
+    if (node.isLeader()) {
+        MPI_Datatype rowType = createRowType(nodeResult);
+        MPI_Gatherv(rowAddress(nodeResult, 1), node.nodeRows, rowType,
+                    result ? rowAddress(result, 0) : nullptr, node.nodeCounts.data(), node.nodeStarts.data(),
+                    rowType, 0, node.leaderComm);
+        MPI_Type_free(&rowType);
+    }
+    return result;
+}
+
+Image* MPIFilter::gatherImage(const Image* localResult, int width, int height, int maxVal,
+                              const std::string& magicNumber, int rank, int size) {
+    RowDecomposition rows(height, size);
+    Image* result = nullptr;
+    
+    if (rank == 0) {
+        std::cout << "Recopilando resultados de " << size << " procesos..." << std::endl;
+        result = createImage(width, height, maxVal, magicNumber);
+    }
+    
+    // Las filas propias de cada bloque van directamente a su posición final
+    MPI_Datatype rowType = createRowType(localResult);
+    MPI_Gatherv(rowAddress(localResult, 1), rows.counts[rank], rowType,
+                result ? rowAddress(result, 0) : nullptr, rows.counts.data(), rows.starts.data(), rowType,
+                0, MPI_COMM_WORLD);
+    MPI_Type_free(&rowType);
+    return result;
 }
@@ -2,24 +2,211 @@
 #define MPIFILTER_H
 
 #include "Filter.h"
+#include "Convolution.h"
+#include "ImageIO.h"
 #include <mpi.h>
+#include <string>
+#include <vector>
 
+// Reparto 1D por bloques de filas: el proceso i recibe counts[i] filas
+// consecutivas a partir de starts[i]. Los primeros height % size procesos
+// reciben una fila más; si hay más procesos que filas, los últimos no
+// reciben ninguna
+struct RowDecomposition {
+    std::vector<int> counts;
+    std::vector<int> starts;
+    
+    RowDecomposition(int height, int size);
+};
+
+// Reparto 2D por bloques sobre una malla de dims[0] x dims[1] procesos: las
+// filas se reparten entre las filas de la malla y las columnas entre sus
+// columnas, ambas como en RowDecomposition. La malla se elige según la forma
+// de la imagen para minimizar el perímetro (los halos) del bloque más grande.
+// El proceso r ocupa la posición (r / dims[1], r % dims[1]), el orden de
+// MPI_Cart_create sin reordenar
+struct BlockDecomposition {
+    int dims[2];
+    RowDecomposition rows;
+    RowDecomposition cols;
+    
+    BlockDecomposition(int width, int height, int size);
+};
+
+// Memoria compartida por nodo (modo --shm). Los procesos de un mismo nodo
+// (MPI_Comm_split_type con MPI_COMM_TYPE_SHARED) comparten el bloque de
+// entrada y el de salida del nodo en una ventana MPI_Win_allocate_shared: las
+// filas del nodo más un halo arriba y otro abajo, con la disposición del
+// bloque local de MPIFilter. Las filas se reparten como en
+// RowDecomposition(height, size) numerando los procesos nodo a nodo, así cada
+// nodo tiene un tramo contiguo. Solo los procesos 0 de cada nodo envían
+// mensajes; los demás leen los halos directamente de la ventana
+struct NodeWindow {
+    MPI_Comm nodeComm;
+    MPI_Comm leaderComm;       // Procesos 0 de cada nodo (MPI_COMM_NULL en los demás)
+    MPI_Win window;
+    int nodeRank;
+    int nodeSize;
+    int nodeStart;             // Filas globales del nodo
+    int nodeRows;
+    int firstRow;              // Filas globales propias de este proceso
+    int rowCount;
+    std::vector<int> nodeStarts;   // Tramos de todos los nodos (solo en los procesos 0)
+    std::vector<int> nodeCounts;
+    unsigned char* input;      // Bloques del nodo dentro de la ventana
+    unsigned char* output;
+    
+    // Colectiva sobre MPI_COMM_WORLD
+    NodeWindow(int width, int height, int maxVal, const std::string& magicNumber);
+    ~NodeWindow();
+    
+    bool isLeader() const { return nodeRank == 0; }
+    // Barrera del nodo que además hace visibles las escrituras en la ventana
+    void synchronize();
+    
+private:
+    // No copiable
+    NodeWindow(const NodeWindow&);
+    NodeWindow& operator=(const NodeWindow&);
+};
+
+// Bloque local de un proceso: sus filas propias más una fila de halo arriba
+// y otra abajo. La fila local 0 es el halo superior, las filas 1..rows son
+// las propias (filas globales firstRow..firstRow+rows-1) y la fila rows+1 es
+// el halo inferior
 class MPIFilter {
 public:
-    static Image* applyFilterDistributed(const Image* input, Filter* filter, 
-                                       int rank, int size);
+    // Con overlap, los halos se intercambian con MPI_Isend/MPI_Irecv mientras
+    // se filtran las filas interiores del bloque, y las dos filas de los
+    // extremos se filtran al completarse la comunicación
+    static void setOverlap(bool enabled);
     
-    static void distributeImage(const Image* image, int rank, int size);
-    static Image* gatherImage(const Image* localResult, int width, int height, int maxVal, 
-                             const std::string& magicNumber, int rank, int size);
+    // Número de veces que applyFilterDistributed aplica el filtro (cada
+    // pasada sobre el resultado de la anterior). Con más de una, el bloque
+    // local y el de salida se alternan como doble buffer y los halos se
+    // intercambian con solicitudes persistentes (MPI_Send_init/MPI_Recv_init)
+    // creadas una sola vez y reiniciadas con MPI_Startall en cada pasada
+    static void setIterations(int count);
+    static int getIterations() { return iterations; }
+    
+    // Modo híbrido MPI + OpenMP: con threads > 1 cada proceso filtra su
+    // bloque con el motor de teselas de OpenMP (OMPFilter::filterRows) usando
+    // 'threads' hilos; con 0 usa omp_get_max_threads() (OMP_NUM_THREADS del
+    // proceso). Solo el hilo principal llama a MPI (MPI_THREAD_FUNNELED)
+    static void setThreads(int threads);
+    static int getThreads() { return threads; }
+    
+    // Filtra una imagen completa en el proceso que la llama (sin
+    // comunicación), con los hilos de setThreads. Lo usa el modo por lotes
+    static Image* filterImage(const Image* image, Filter* filter);
+    
+    // Reparte las filas de 'image' (solo se usa en el proceso 0) con
+    // MPI_Scatterv. Todos los procesos reciben su bloque local con espacio
+    // para los halos; los halos se completan en applyFilterDistributed
+    static Image* distributeImage(const Image* image, int width, int height, int maxVal,
+                                  const std::string& magicNumber, int rank, int size);
+    
+    // Intercambia los halos con los procesos vecinos y filtra solo las filas
+    // propias del bloque local. Devuelve un bloque con la misma disposición.
+    // Con varias iteraciones el contenido de localBlock se sobrescribe
+    static Image* applyFilterDistributed(Image* localBlock, Filter* filter, int height,
+                                         int rank, int size);
+    
+    // Reúne en el proceso 0 las filas propias de cada bloque local con
+    // MPI_Gatherv. Devuelve la imagen completa en el proceso 0 y nullptr en
+    // los demás
+    static Image* gatherImage(const Image* localResult, int width, int height, int maxVal,
+                              const std::string& magicNumber, int rank, int size);
+    
+    // E/S paralela con MPI-IO para P5/P6: cada proceso lee o escribe
+    // directamente su bloque de filas en el archivo.
+    // probeBinaryImage (solo en el proceso 0) analiza el encabezado y
+    // devuelve true si el archivo es un P5/P6 válido y completo
+    static bool probeBinaryImage(const std::string& filename, ImageHeader& header);
+    // Lee con MPI_File_read_at_all el bloque local (con espacio para halos)
+    // a partir de header.dataOffset; todos los procesos reciben 'header'
+    static Image* readImageParallel(const std::string& filename, const ImageHeader& header,
+                                    int rank, int size);
+    // Escribe las filas propias de cada bloque con MPI_File_write_at_all; el
+    // proceso 0 escribe el encabezado. El número mágico del bloque debe ser
+    // P5 o P6. El archivo es idéntico al de writeToFile
+    static bool writeImageParallel(const std::string& filename, const Image* localResult, int height,
+                                   int rank, int size);
+    
+    // Lectura distribuida de P2/P3: cada proceso proyecta el archivo, cuenta
+    // los tokens de su tramo de bytes (alineado a espacios) y con MPI_Exscan
+    // obtiene el índice global del primer token de su tramo. Con esos índices
+    // cada proceso localiza el token donde empiezan sus filas y decodifica
+    // solo sus filas y las de halo.
+    // probeAsciiImage (solo en el proceso 0) devuelve true si el encabezado
+    // es un P2/P3 válido. readAsciiParallel devuelve nullptr en todos los
+    // procesos si faltan muestras o alguna es inválida, con las mismas reglas
+    // que la lectura secuencial ("12-7" son dos muestras, "12x" es un error);
+    // el proceso 0 puede entonces cargar el archivo para informar del error
+    static bool probeAsciiImage(const std::string& filename, ImageHeader& header);
+    static Image* readAsciiParallel(const std::string& filename, const ImageHeader& header,
+                                    int rank, int size);
+    
+    // Descomposición 2D. El bloque local de un proceso tiene un halo en cada
+    // lado: filas y columnas 1..n son las propias, 0 y n+1 son los halos.
+    // createGrid crea el comunicador cartesiano (sin periodicidad ni
+    // reordenación, así el proceso 0 sigue siendo el 0); hay que liberarlo
+    // con MPI_Comm_free
+    static MPI_Comm createGrid(const BlockDecomposition& blocks);
+    // Envía a cada proceso su bloque de 'image' (solo en el proceso 0)
+    static Image* distributeBlocks(const Image* image, int maxVal, const std::string& magicNumber,
+                                   const BlockDecomposition& blocks, MPI_Comm grid);
+    // Intercambia los halos con los cuatro vecinos de la malla y filtra el
+    // bloque propio. Devuelve un bloque con la misma disposición
+    static Image* applyFilterBlocks(Image* localBlock, Filter* filter, const BlockDecomposition& blocks,
+                                    MPI_Comm grid);
+    // Reúne los bloques propios en el proceso 0 (nullptr en los demás)
+    static Image* gatherBlocks(const Image* localResult, int width, int height, int maxVal,
+                               const std::string& magicNumber, const BlockDecomposition& blocks,
+                               MPI_Comm grid);
+    
+    // Modo de memoria compartida (ver NodeWindow). Los bloques que devuelven
+    // son vistas sobre la ventana del nodo (se pueden borrar sin liberarla).
+    // distributeShared reparte las filas de 'image' (solo en el proceso 0)
+    // entre los procesos 0 de cada nodo con MPI_Scatterv
+    static Image* distributeShared(const Image* image, int width, int maxVal, const std::string& magicNumber,
+                                   NodeWindow& node);
+    // Los procesos 0 intercambian los halos entre nodos; después cada proceso
+    // filtra sus filas leyendo la entrada compartida del nodo y escribe en la
+    // salida compartida
+    static Image* applyFilterShared(Image* nodeBlock, Filter* filter, NodeWindow& node);
+    // Reúne en el proceso 0 las filas de cada nodo con MPI_Gatherv
+    static Image* gatherShared(const Image* nodeResult, int width, int height, int maxVal,
+                               const std::string& magicNumber, NodeWindow& node);
     
 private:
+    static bool overlap;
+    static int threads;
+    static int iterations;
+    
+    // Actualiza las filas de halo del bloque local: las intercambia con los
+    // vecinos (MPI_Sendrecv) y, en los bordes de la imagen, replica la fila
+    // propia del extremo, que es lo mismo que hace el filtro en el borde
+    static void exchangeHalos(Image* localBlock, int height, int rank, int size);
+    // Versión no bloqueante: inicia el intercambio en 'requests' (4
+    // solicitudes) usando 'rowType'; se completa con MPI_Waitall
+    static void startHaloExchange(Image* localBlock, int height, int rank, int size,
+                                  MPI_Datatype rowType, MPI_Request requests[4]);
+    // Halos del bloque 2D: primero las columnas (solo filas propias, con
+    // MPI_Type_vector) y después las filas con el ancho completo, que ya
+    // incluyen las columnas recibidas: así llegan también las esquinas
+    static void exchangeBlockHalos(Image* localBlock, const BlockDecomposition& blocks, MPI_Comm grid);
+    // Halos entre nodos (solo los procesos 0 de cada nodo)
+    static void exchangeNodeHalos(Image* nodeBlock, const NodeWindow& node);
+    // Pasadas repetidas del filtro con doble buffer y solicitudes persistentes
+    static Image* applyFilterIterated(Image* localBlock, Image* output, Filter* filter, int height,
+                                      int rank, int size);
     static void processRegion(const Image* input, Image* output, Filter* filter,
-                            int startY, int endY);
-    static void copyRegion(const Image* source, Image* dest, int srcStartY, int destStartY, 
-                          int width, int height);
-    static void sendRegion(const Image* image, int startY, int endY, int width, int dest);
-    static void receiveRegion(Image* image, int startY, int endY, int width, int source);
+                              int startY, int endY);
+    static void copyRegion(const Image* source, Image* dest, int srcStartY, int destStartY, int rows);
+    
+    // Imagen vacía del tipo indicado por el número mágico
+    static Image* createImage(int width, int height, int maxVal, const std::string& magicNumber);
 };
 
 #endif // MPIFILTER_H
@@ -4,148 +4,120 @@
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <algorithm>
+
+int OMPFilter::tileSize = 0;
+bool OMPFilter::bands = false;
+
+void OMPFilter::setTiling(int size, bool rowBands) {
+    tileSize = size > 0 ? size : 0;
+    bands = rowBands;
+}
+
+const char* OMPFilter::getScheduleName(omp_sched_t kind) {
+    // El bit de monotonicidad (OpenMP 4.5) no cambia el tipo
+    switch ((int)kind & 0xff) {
+        case omp_sched_static: return "static";
+        case omp_sched_dynamic: return "dynamic";
+        case omp_sched_guided: return "guided";
+        case omp_sched_auto: return "auto";
+        default: return "desconocida";
+    }
+}
 
 Image* OMPFilter::applyFilterParallel(const Image* input, Filter* filter) {
     if (!input || !filter) return nullptr;
     
-    // Crear imagen de salida
+    // Crear imagen de salida sin inicializar: cada página la toca primero el
+    // hilo que filtra su bloque, así queda en su nodo NUMA (first-touch)
     Image* output = nullptr;
     const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
     const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
     
     if (pgmInput) {
-        output = new PGMImage(input->getWidth(), input->getHeight(), input->getMaxVal());
+        output = new PGMImage(input->getWidth(), input->getHeight(), input->getMaxVal(), false);
     } else if (ppmInput) {
-        output = new PPMImage(input->getWidth(), input->getHeight(), input->getMaxVal());
+        output = new PPMImage(input->getWidth(), input->getHeight(), input->getMaxVal(), false);
     } else {
         return nullptr;
     }
     
-    // Determinar el kernel según el tipo de filtro
-    double kernel[3][3];
-    bool isLaplacian = false;
-    
-    if (strcmp(filter->getName(), "Blur") == 0) {
-        double blurKernel[3][3] = {
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0}
-        };
-        memcpy(kernel, blurKernel, sizeof(kernel));
-    } else if (strcmp(filter->getName(), "Laplacian") == 0) {
-        double laplacianKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  4, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, laplacianKernel, sizeof(kernel));
-        isLaplacian = true;
-    } else if (strcmp(filter->getName(), "Sharpen") == 0) {
-        double sharpenKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  5, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, sharpenKernel, sizeof(kernel));
+    // Determinar el kernel según el tipo de filtro (aritmética entera si el kernel lo permite)
+    Kernel3x3 kernel;
+    if (!getFilterKernel(filter->getName(), kernel)) {
+        delete output;
+        return nullptr;
     }
     
     std::cout << "Aplicando filtro con OpenMP (hilos disponibles: " << omp_get_max_threads() << ")" << std::endl;
     
     // Aplicar filtro usando paralelización OpenMP
-    applyKernelParallel(input, output, kernel, isLaplacian);
+    applyKernelParallel(input, output, kernel);
     
     std::cout << "Procesamiento paralelo con OpenMP completado" << std::endl;
     return output;
 }
 
-void OMPFilter::applyKernelParallel(const Image* input, Image* output, 
-                                   double kernel[3][3], bool isLaplacian) {
-    const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
-    const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
-    PGMImage* pgmOutput = dynamic_cast<PGMImage*>(output);
-    PPMImage* ppmOutput = dynamic_cast<PPMImage*>(output);
-    
+void OMPFilter::getTileShape(const Image* input, int rows, int& tileWidth, int& tileHeight) {
     int width = input->getWidth();
+    if (bands) {
+        tileWidth = width;
+        tileHeight = tileSize > 0 ? tileSize : defaultBandRows(input);
+    } else {
+        tileWidth = tileHeight = tileSize > 0 ? tileSize : defaultTileSize(input);
+    }
+    tileWidth = std::max(1, std::min(tileWidth, width));
+    tileHeight = std::max(1, std::min(tileHeight, rows));
+}
+
+void OMPFilter::applyKernelParallel(const Image* input, Image* output, const Kernel3x3& kernel) {
     int height = input->getHeight();
-    int maxVal = input->getMaxVal();
+    int tileWidth, tileHeight;
+    getTileShape(input, height, tileWidth, tileHeight);
+    int numTiles = ((input->getWidth() + tileWidth - 1) / tileWidth) * ((height + tileHeight - 1) / tileHeight);
     
-    if (pgmInput && pgmOutput) {
-        // Procesar imagen PGM con OpenMP
-        #pragma omp parallel for collapse(2) schedule(dynamic)
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double sum = 0;
-                
-                // Aplicar kernel 3x3
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        // Manejo de bordes
-                        if (px < 0) px = 0;
-                        if (px >= width) px = width - 1;
-                        if (py < 0) py = 0;
-                        if (py >= height) py = height - 1;
-                        
-                        int pixel = pgmInput->getPixel(px, py);
-                        sum += pixel * kernel[ky + 1][kx + 1];
-                    }
-                }
-                
-                int result = (int)std::round(sum);
-                if (isLaplacian) {
-                    result += 128; // Centrar resultado para Laplaciano
-                }
-                result = std::max(0, std::min(maxVal, result));
-                pgmOutput->setPixel(x, y, result);
-            }
-        }
+    omp_sched_t kind;
+    int chunk;
+    omp_get_schedule(&kind, &chunk);
+    std::cout << "Dividiendo imagen en " << numTiles << (bands ? " bandas de " : " teselas de ")
+              << tileWidth << "x" << tileHeight << " (planificación " << getScheduleName(kind)
+              << ", bloque " << chunk << ")" << std::endl;
+    
+    filterRows(input, output, kernel, 0, height);
+}
+
+void OMPFilter::filterRows(const Image* input, Image* output, const Kernel3x3& kernel,
+                           int startY, int endY) {
+    if (endY <= startY) return;
+    
+    int width = input->getWidth();
+    int tileWidth, tileHeight;
+    getTileShape(input, endY - startY, tileWidth, tileHeight);
+    int tilesPerRow = (width + tileWidth - 1) / tileWidth;
+    int numTiles = tilesPerRow * ((endY - startY + tileHeight - 1) / tileHeight);
+    
+    // Una tesela por iteración, en orden de filas: cada hilo escribe bloques
+    // completos de la salida y nunca comparte líneas de caché salvo en los
+    // bordes verticales de las teselas
+    #pragma omp parallel for schedule(runtime)
+    for (int tile = 0; tile < numTiles; tile++) {
+        int x0 = (tile % tilesPerRow) * tileWidth;
+        int y0 = startY + (tile / tilesPerRow) * tileHeight;
+        convolveRegion(input, output, kernel, x0, std::min(x0 + tileWidth, width),
+                       y0, std::min(y0 + tileHeight, endY));
+    }
+}
+
+void OMPStreamFilter::runStep(int rowsInBand) {
+    #pragma omp parallel
+    {
+        // Un hilo hace la E/S; al terminar se une al reparto de filas
+        #pragma omp single nowait
+        transferIO();
         
-    } else if (ppmInput && ppmOutput) {
-        // Procesar imagen PPM con OpenMP
-        #pragma omp parallel for collapse(2) schedule(dynamic)
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                double sumR = 0, sumG = 0, sumB = 0;
-                
-                // Aplicar kernel 3x3
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        // Manejo de bordes
-                        if (px < 0) px = 0;
-                        if (px >= width) px = width - 1;
-                        if (py < 0) py = 0;
-                        if (py >= height) py = height - 1;
-                        
-                        RGB pixel = ppmInput->getPixel(px, py);
-                        double kernelValue = kernel[ky + 1][kx + 1];
-                        
-                        sumR += pixel.r * kernelValue;
-                        sumG += pixel.g * kernelValue;
-                        sumB += pixel.b * kernelValue;
-                    }
-                }
-                
-                int r = (int)std::round(sumR);
-                int g = (int)std::round(sumG);
-                int b = (int)std::round(sumB);
-                
-                if (isLaplacian) {
-                    r += 128;
-                    g += 128;
-                    b += 128;
-                }
-                
-                r = std::max(0, std::min(maxVal, r));
-                g = std::max(0, std::min(maxVal, g));
-                b = std::max(0, std::min(maxVal, b));
-                
-                ppmOutput->setPixel(x, y, RGB(r, g, b));
-            }
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < rowsInBand; i++) {
+            filterRow(i);
         }
     }
 }
@@ -2,15 +2,51 @@
 #define OMPFILTER_H
 
 #include "Filter.h"
+#include "StreamFilter.h"
+#include "Convolution.h"
 #include <omp.h>
 
 class OMPFilter {
 public:
+    // Forma de los bloques de trabajo: teselas cuadradas de 'size' píxeles de
+    // lado o, con rowBands, bandas de ancho completo de 'size' filas. Con
+    // size == 0 se elige según la caché (defaultTileSize/defaultBandRows)
+    static void setTiling(int size, bool rowBands);
+    
+    // Aplica el filtro repartiendo los bloques con schedule(runtime): la
+    // planificación es la fijada con omp_set_schedule() u OMP_SCHEDULE
     static Image* applyFilterParallel(const Image* input, Filter* filter);
     
+    // Filtra las filas [startY, endY) repartiendo sus teselas entre los hilos
+    // con schedule(runtime). También lo usa el modo híbrido MPI + OpenMP
+    // sobre el bloque local de cada proceso
+    static void filterRows(const Image* input, Image* output, const Kernel3x3& kernel,
+                           int startY, int endY);
+    
+    // Nombre de una planificación de OpenMP ("static", "dynamic", ...)
+    static const char* getScheduleName(omp_sched_t kind);
+    
 private:
-    static void applyKernelParallel(const Image* input, Image* output, 
-                                  double kernel[3][3], bool isLaplacian);
+    static int tileSize;
+    static bool bands;
+    
+    static void applyKernelParallel(const Image* input, Image* output, const Kernel3x3& kernel);
+    // Dimensiones de las teselas según setTiling() para una región de 'rows' filas
+    static void getTileShape(const Image* input, int rows, int& tileWidth, int& tileHeight);
+};
+
+// Modo streaming con OpenMP: las filas de cada banda se filtran en paralelo
+// mientras un hilo escribe la banda anterior y lee la siguiente
+class OMPStreamFilter : public StreamFilter {
+public:
+    // Filas por banda por defecto: suficientes para repartir entre los hilos
+    static const int DEFAULT_BAND_ROWS = 64;
+    
+    OMPStreamFilter(const Kernel3x3& kernel, int bandRows = DEFAULT_BAND_ROWS)
+        : StreamFilter(kernel, bandRows) {}
+    
+protected:
+    void runStep(int rowsInBand) override;
 };
 
 #endif // OMPFILTER_H
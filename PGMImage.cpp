@@ -1,19 +1,36 @@
 #include "PGMImage.h"
+#include "ImageIO.h"
 #include <sstream>
+#include <cstring>
 
-PGMImage::PGMImage() : Image(), pixels(nullptr) {}
+PGMImage::PGMImage() : Image(), pixels(nullptr), stride(0), ownsPixels(true) {}
 
-PGMImage::PGMImage(int w, int h, int max) : Image(w, h, max), pixels(nullptr) {
+PGMImage::PGMImage(int w, int h, int max, bool zeroFill)
+    : Image(w, h, max), pixels(nullptr), stride(0), ownsPixels(true) {
     magicNumber = "P2";
-    allocateMemory();
+    allocateMemory(zeroFill);
+}
+
+PGMImage::PGMImage(int w, int h, int max, unsigned char* buffer)
+    : Image(w, h, max), pixels(buffer), stride(0), ownsPixels(false) {
+    magicNumber = "P2";
+    sampleSize = sampleSizeFor(maxVal);
+    stride = alignedStride(width, sampleSize) * sampleSize;
+}
+
+size_t PGMImage::bufferBytes(int w, int h, int max) {
+    int size = sampleSizeFor(max);
+    return (size_t)alignedStride(w, size) * size * h;
 }
 
 PGMImage::~PGMImage() {
     deallocateMemory();
 }
 
-PGMImage::PGMImage(const PGMImage& other) : Image(other.width, other.height, other.maxVal) {
+PGMImage::PGMImage(const PGMImage& other)
+    : Image(other.width, other.height, other.maxVal), pixels(nullptr), stride(0), ownsPixels(true) {
     magicNumber = other.magicNumber;
+    ioThreads = other.ioThreads;
     allocateMemory();
     copyPixels(other);
 }
@@ -25,6 +42,7 @@ PGMImage& PGMImage::operator=(const PGMImage& other) {
         height = other.height;
         maxVal = other.maxVal;
         magicNumber = other.magicNumber;
+        ioThreads = other.ioThreads;
         allocateMemory();
         copyPixels(other);
     }
@@ -32,39 +50,37 @@ PGMImage& PGMImage::operator=(const PGMImage& other) {
 }
 
 bool PGMImage::readFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    // Cargar el archivo completo en memoria y analizar el encabezado
+    MappedFile file;
+    if (!file.open(filename)) {
         std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
         return false;
     }
+    ImageHeader header;
+    parseImageHeader(file.data(), file.size(), header);
     
-    // Leer número mágico
-    file >> magicNumber;
-    if (magicNumber != "P2") {
-        std::cerr << "Error: Formato de archivo no válido. Se esperaba P2" << std::endl;
+    return readFromMemory(file, header);
+}
+
+bool PGMImage::readFromMemory(const MappedFile& file, const ImageHeader& header) {
+    // Validar número mágico
+    magicNumber = header.magicNumber;
+    if (magicNumber != "P2" && magicNumber != "P5") {
+        std::cerr << "Error: Formato de archivo no válido. Se esperaba P2 o P5" << std::endl;
         return false;
     }
     
-    // Saltar comentarios
-    skipComments(file);
-    
-    // Leer dimensiones
-    file >> width >> height;
-    
     // Validar dimensiones
+    width = header.width;
+    height = header.height;
     if (width <= 0 || height <= 0) {
         std::cerr << "Error: Dimensiones inválidas: " << width << " x " << height << std::endl;
         return false;
     }
     
-    // Saltar comentarios
-    skipComments(file);
-    
-    // Leer valor máximo
-    file >> maxVal;
-    
     // Validar valor máximo
-    if (maxVal <= 0) {
+    maxVal = header.maxVal;
+    if (maxVal <= 0 || maxVal > MAX_SAMPLE_VALUE) {
         std::cerr << "Error: Valor máximo inválido: " << maxVal << std::endl;
         return false;
     }
@@ -73,50 +89,129 @@ bool PGMImage::readFromFile(const std::string& filename) {
     deallocateMemory();
     allocateMemory();
     
-    // Leer píxeles
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            file >> pixels[i][j];
-            if (file.fail()) {
-                std::cerr << "Error: Error al leer píxel en posición (" << i << ", " << j << ")" << std::endl;
+    const char* data = file.data() + header.dataOffset;
+    const char* fileEnd = file.data() + file.size();
+    size_t samplesPerRow = (size_t)width;
+    
+    if (isBinary()) {
+        // P5: las muestras binarias empiezan en header.dataOffset
+        size_t available = (size_t)(fileEnd - data);
+        size_t rowBytes = samplesPerRow * sampleSize;
+        
+        // Copiar cada fila directamente al buffer de la imagen
+        for (int i = 0; i < height; i++) {
+            if (available < rowBytes) {
+                std::cerr << "Error: Error al leer píxel en posición (" << i << ", " << available / sampleSize << ")" << std::endl;
                 return false;
             }
+            if (sampleSize == 1) decodeBinarySamples(data, row<uint8_t>(i).data(), samplesPerRow, maxVal);
+            else decodeBinarySamples(data, row<uint16_t>(i).data(), samplesPerRow, maxVal);
+            data += rowBytes;
+            available -= rowBytes;
+        }
+        return true;
+    }
+    
+    if (ioThreads > 1) {
+        // Decodificación en paralelo directamente sobre el buffer de la imagen
+        size_t total = samplesPerRow * height;
+        size_t read = (sampleSize == 1)
+            ? readSamplesParallel(data, fileEnd, row<uint8_t>(0).data(), stride,
+                                  samplesPerRow, height, maxVal, ioThreads)
+            : readSamplesParallel(data, fileEnd, row<uint16_t>(0).data(), stride,
+                                  samplesPerRow, height, maxVal, ioThreads);
+        if (read < total) {
+            std::cerr << "Error: Error al leer píxel en posición (" << read / samplesPerRow << ", "
+                      << read % samplesPerRow << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Leer píxeles
+    TextScanner scanner(data, fileEnd);
+    for (int i = 0; i < height; i++) {
+        size_t read = (sampleSize == 1)
+            ? scanner.readSamples(row<uint8_t>(i).data(), samplesPerRow, maxVal)
+            : scanner.readSamples(row<uint16_t>(i).data(), samplesPerRow, maxVal);
+        if (read < samplesPerRow) {
+            std::cerr << "Error: Error al leer píxel en posición (" << i << ", " << read << ")" << std::endl;
+            return false;
         }
     }
     
-    file.close();
     return true;
 }
 
 bool PGMImage::writeToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    // Encabezado
+    std::string header = formatHeader(magicNumber, width, height, maxVal);
+    
+    size_t samplesPerRow = (size_t)width;
+    if (!isBinary() && ioThreads > 1) {
+        // Bandas de filas formateadas en paralelo y escritas con pwrite
+        bool ok = (sampleSize == 1)
+            ? writeAsciiParallel(filename, header, row<uint8_t>(0).data(), stride,
+                                 samplesPerRow, height, 1, ioThreads)
+            : writeAsciiParallel(filename, header, row<uint16_t>(0).data(), stride,
+                                 samplesPerRow, height, 1, ioThreads);
+        if (!ok) {
+            std::cerr << "Error: No se pudo escribir el archivo " << filename << std::endl;
+        }
+        return ok;
+    }
+    
+    BufferedWriter file;
+    if (!file.open(filename)) {
         std::cerr << "Error: No se pudo crear el archivo " << filename << std::endl;
         return false;
     }
-    
-    // Escribir encabezado
-    file << magicNumber << std::endl;
-    file << "# Generado por PGMImage" << std::endl;
-    file << width << " " << height << std::endl;
-    file << maxVal << std::endl;
+    file.write(header);
     
     // Escribir píxeles
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            file << pixels[i][j];
-            if (j < width - 1) file << " ";
+    if (isBinary()) {
+        // Filas sin relleno; 16 bits se guardan en big-endian
+        std::vector<char> encoded(sampleSize == 2 ? samplesPerRow * 2 : 0);
+        for (int i = 0; i < height; i++) {
+            if (sampleSize == 1) {
+                file.write(reinterpret_cast<const char*>(row<uint8_t>(i).data()), samplesPerRow);
+            } else {
+                encodeBinarySamples(row<uint16_t>(i).data(), samplesPerRow, encoded.data());
+                file.write(encoded.data(), encoded.size());
+            }
+        }
+    } else {
+        // Cada fila se formatea directamente en el buffer de escritura
+        for (int i = 0; i < height; i++) {
+            char* line = file.reserve(asciiRowCapacity(samplesPerRow));
+            if (line == nullptr) break;
+            size_t length = (sampleSize == 1)
+                ? formatAsciiRow(row<uint8_t>(i).data(), samplesPerRow, 1, line)
+                : formatAsciiRow(row<uint16_t>(i).data(), samplesPerRow, 1, line);
+            file.commit(length);
         }
-        file << std::endl;
     }
     
-    file.close();
+    if (!file.close()) {
+        std::cerr << "Error: No se pudo escribir el archivo " << filename << std::endl;
+        return false;
+    }
     return true;
 }
 
+std::string PGMImage::formatHeader(const std::string& magic, int w, int h, int max) {
+    std::ostringstream header;
+    header << magic << "\n";
+    header << "# Generado por PGMImage" << "\n";
+    header << w << " " << h << "\n";
+    header << max << "\n";
+    return header.str();
+}
+
 int PGMImage::getPixel(int x, int y) const {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-        return pixels[y][x];
+        if (sampleSize == 1) return row<uint8_t>(y)[x];
+        return row<uint16_t>(y)[x];
     }
     return 0;
 }
@@ -126,7 +221,8 @@ void PGMImage::setPixel(int x, int y, int value) {
         // Asegurar que el valor esté en el rango válido
         if (value < 0) value = 0;
         if (value > maxVal) value = maxVal;
-        pixels[y][x] = value;
+        if (sampleSize == 1) row<uint8_t>(y)[x] = (uint8_t)value;
+        else row<uint16_t>(y)[x] = (uint16_t)value;
     }
 }
 
@@ -134,35 +230,28 @@ PGMImage* PGMImage::clone() const {
     return new PGMImage(*this);
 }
 
-void PGMImage::allocateMemory() {
+void PGMImage::allocateMemory(bool zeroFill) {
+    ownsPixels = true;
     if (width > 0 && height > 0) {
-        pixels = new int*[height];
-        for (int i = 0; i < height; i++) {
-            pixels[i] = new int[width];
-            // Inicializar con 0
-            for (int j = 0; j < width; j++) {
-                pixels[i][j] = 0;
-            }
-        }
+        sampleSize = sampleSizeFor(maxVal);
+        stride = alignedStride(width, sampleSize) * sampleSize;
+        size_t bytes = (size_t)stride * height;
+        pixels = static_cast<unsigned char*>(allocateAligned(bytes));
+        // Inicializar con 0 (incluye el relleno)
+        if (zeroFill) memset(pixels, 0, bytes);
     }
 }
 
 void PGMImage::deallocateMemory() {
     if (pixels != nullptr) {
-        for (int i = 0; i < height; i++) {
-            delete[] pixels[i];
-        }
-        delete[] pixels;
+        if (ownsPixels) freeAligned(pixels);
         pixels = nullptr;
     }
 }
 
 void PGMImage::copyPixels(const PGMImage& other) {
     if (pixels != nullptr && other.pixels != nullptr) {
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                pixels[i][j] = other.pixels[i][j];
-            }
-        }
+        // Mismas dimensiones implican el mismo stride: una sola copia
+        memcpy(pixels, other.pixels, (size_t)stride * height);
     }
 }
\ No newline at end of file
@@ -5,12 +5,22 @@
 
 class PGMImage : public Image {
 private:
-    int** pixels;  // Matriz de píxeles (escala de grises)
+    unsigned char* pixels;  // Buffer contiguo de muestras (fila mayor, alineado a 64 bytes)
+    int stride;             // Bytes por fila, incluyendo el relleno de alineación
+    bool ownsPixels;        // false si el buffer es externo (no se libera)
     
 public:
     // Constructor
     PGMImage();
-    PGMImage(int w, int h, int max);
+    // Con zeroFill == false el buffer no se inicializa: el llamador debe
+    // escribir todas las muestras, y la primera escritura de cada página
+    // decide en qué nodo NUMA queda (first-touch)
+    PGMImage(int w, int h, int max, bool zeroFill = true);
+    // Imagen sobre un buffer externo alineado a PIXEL_ALIGNMENT de al menos
+    // bufferBytes(w, h, max) bytes (p. ej. una ventana de memoria compartida
+    // de MPI). El buffer no se inicializa ni se libera con la imagen
+    PGMImage(int w, int h, int max, unsigned char* buffer);
+    static size_t bufferBytes(int w, int h, int max);
     
     // Destructor
     ~PGMImage();
@@ -24,17 +34,32 @@ public:
     // Implementación de métodos virtuales
     bool readFromFile(const std::string& filename) override;
     bool writeToFile(const std::string& filename) const override;
+    bool readFromMemory(const MappedFile& file, const ImageHeader& header) override;
+    
+    // Encabezado que escribe writeToFile (también lo usa la escritura paralela con MPI-IO)
+    static std::string formatHeader(const std::string& magic, int w, int h, int max);
     
     // Métodos específicos de PGM
     int getPixel(int x, int y) const;
     void setPixel(int x, int y, int value);
     
+    // Acceso directo a la fila y (width muestras) sin verificación de límites,
+    // para recorridos masivos en filtros y E/S. T debe ser uint8_t si
+    // getSampleSize() == 1 y uint16_t si getSampleSize() == 2
+    template <typename T>
+    RowView<T> row(int y) { return RowView<T>(reinterpret_cast<T*>(pixels + (size_t)y * stride), (size_t)width); }
+    template <typename T>
+    RowView<const T> row(int y) const {
+        return RowView<const T>(reinterpret_cast<const T*>(pixels + (size_t)y * stride), (size_t)width);
+    }
+    int getStride() const { return stride; }
+    
     // Método para crear copia
     PGMImage* clone() const;
     
 private:
     // Métodos auxiliares
-    void allocateMemory();
+    void allocateMemory(bool zeroFill = true);
     void deallocateMemory();
     void copyPixels(const PGMImage& other);
 };
@@ -1,19 +1,36 @@
 #include "PPMImage.h"
+#include "ImageIO.h"
 #include <sstream>
+#include <cstring>
 
-PPMImage::PPMImage() : Image(), pixels(nullptr) {}
+PPMImage::PPMImage() : Image(), pixels(nullptr), stride(0), ownsPixels(true) {}
 
-PPMImage::PPMImage(int w, int h, int max) : Image(w, h, max), pixels(nullptr) {
+PPMImage::PPMImage(int w, int h, int max, bool zeroFill)
+    : Image(w, h, max), pixels(nullptr), stride(0), ownsPixels(true) {
     magicNumber = "P3";
-    allocateMemory();
+    allocateMemory(zeroFill);
+}
+
+PPMImage::PPMImage(int w, int h, int max, unsigned char* buffer)
+    : Image(w, h, max), pixels(buffer), stride(0), ownsPixels(false) {
+    magicNumber = "P3";
+    sampleSize = sampleSizeFor(maxVal);
+    stride = alignedStride(3 * width, sampleSize) * sampleSize;
+}
+
+size_t PPMImage::bufferBytes(int w, int h, int max) {
+    int size = sampleSizeFor(max);
+    return (size_t)alignedStride(3 * w, size) * size * h;
 }
 
 PPMImage::~PPMImage() {
     deallocateMemory();
 }
 
-PPMImage::PPMImage(const PPMImage& other) : Image(other.width, other.height, other.maxVal) {
+PPMImage::PPMImage(const PPMImage& other)
+    : Image(other.width, other.height, other.maxVal), pixels(nullptr), stride(0), ownsPixels(true) {
     magicNumber = other.magicNumber;
+    ioThreads = other.ioThreads;
     allocateMemory();
     copyPixels(other);
 }
@@ -25,6 +42,7 @@ PPMImage& PPMImage::operator=(const PPMImage& other) {
         height = other.height;
         maxVal = other.maxVal;
         magicNumber = other.magicNumber;
+        ioThreads = other.ioThreads;
         allocateMemory();
         copyPixels(other);
     }
@@ -32,39 +50,37 @@ PPMImage& PPMImage::operator=(const PPMImage& other) {
 }
 
 bool PPMImage::readFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    // Cargar el archivo completo en memoria y analizar el encabezado
+    MappedFile file;
+    if (!file.open(filename)) {
         std::cerr << "Error: No se pudo abrir el archivo " << filename << std::endl;
         return false;
     }
+    ImageHeader header;
+    parseImageHeader(file.data(), file.size(), header);
     
-    // Leer número mágico
-    file >> magicNumber;
-    if (magicNumber != "P3") {
-        std::cerr << "Error: Formato de archivo no válido. Se esperaba P3" << std::endl;
+    return readFromMemory(file, header);
+}
+
+bool PPMImage::readFromMemory(const MappedFile& file, const ImageHeader& header) {
+    // Validar número mágico
+    magicNumber = header.magicNumber;
+    if (magicNumber != "P3" && magicNumber != "P6") {
+        std::cerr << "Error: Formato de archivo no válido. Se esperaba P3 o P6" << std::endl;
         return false;
     }
     
-    // Saltar comentarios
-    skipComments(file);
-    
-    // Leer dimensiones
-    file >> width >> height;
-    
     // Validar dimensiones
+    width = header.width;
+    height = header.height;
     if (width <= 0 || height <= 0) {
         std::cerr << "Error: Dimensiones inválidas: " << width << " x " << height << std::endl;
         return false;
     }
     
-    // Saltar comentarios
-    skipComments(file);
-    
-    // Leer valor máximo
-    file >> maxVal;
-    
     // Validar valor máximo
-    if (maxVal <= 0) {
+    maxVal = header.maxVal;
+    if (maxVal <= 0 || maxVal > MAX_SAMPLE_VALUE) {
         std::cerr << "Error: Valor máximo inválido: " << maxVal << std::endl;
         return false;
     }
@@ -73,52 +89,133 @@ bool PPMImage::readFromFile(const std::string& filename) {
     deallocateMemory();
     allocateMemory();
     
-    // Leer píxeles
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            int r, g, b;
-            file >> r >> g >> b;
-            if (file.fail()) {
-                std::cerr << "Error: Error al leer píxel RGB en posición (" << i << ", " << j << ")" << std::endl;
+    const char* data = file.data() + header.dataOffset;
+    const char* fileEnd = file.data() + file.size();
+    size_t samplesPerRow = 3 * (size_t)width;
+    
+    if (isBinary()) {
+        // P6: las muestras binarias empiezan en header.dataOffset
+        size_t available = (size_t)(fileEnd - data);
+        size_t rowBytes = samplesPerRow * sampleSize;
+        
+        // Copiar cada fila directamente al buffer de la imagen
+        for (int i = 0; i < height; i++) {
+            if (available < rowBytes) {
+                std::cerr << "Error: Error al leer píxel RGB en posición (" << i << ", " << available / sampleSize / 3 << ")" << std::endl;
                 return false;
             }
-            pixels[i][j] = RGB(r, g, b);
+            if (sampleSize == 1) decodeBinarySamples(data, row<uint8_t>(i).data(), samplesPerRow, maxVal);
+            else decodeBinarySamples(data, row<uint16_t>(i).data(), samplesPerRow, maxVal);
+            data += rowBytes;
+            available -= rowBytes;
+        }
+        return true;
+    }
+    
+    if (ioThreads > 1) {
+        // Decodificación en paralelo directamente sobre el buffer de la imagen
+        size_t total = samplesPerRow * height;
+        size_t read = (sampleSize == 1)
+            ? readSamplesParallel(data, fileEnd, row<uint8_t>(0).data(), stride,
+                                  samplesPerRow, height, maxVal, ioThreads)
+            : readSamplesParallel(data, fileEnd, row<uint16_t>(0).data(), stride,
+                                  samplesPerRow, height, maxVal, ioThreads);
+        if (read < total) {
+            std::cerr << "Error: Error al leer píxel RGB en posición (" << read / samplesPerRow << ", "
+                      << read % samplesPerRow / 3 << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Leer píxeles (3 muestras intercaladas por píxel)
+    TextScanner scanner(data, fileEnd);
+    for (int i = 0; i < height; i++) {
+        size_t read = (sampleSize == 1)
+            ? scanner.readSamples(row<uint8_t>(i).data(), samplesPerRow, maxVal)
+            : scanner.readSamples(row<uint16_t>(i).data(), samplesPerRow, maxVal);
+        if (read < samplesPerRow) {
+            std::cerr << "Error: Error al leer píxel RGB en posición (" << i << ", " << read / 3 << ")" << std::endl;
+            return false;
         }
     }
     
-    file.close();
     return true;
 }
 
 bool PPMImage::writeToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    // Encabezado
+    std::string header = formatHeader(magicNumber, width, height, maxVal);
+    
+    size_t samplesPerRow = 3 * (size_t)width;
+    if (!isBinary() && ioThreads > 1) {
+        // Bandas de filas formateadas en paralelo y escritas con pwrite
+        bool ok = (sampleSize == 1)
+            ? writeAsciiParallel(filename, header, row<uint8_t>(0).data(), stride,
+                                 samplesPerRow, height, 3, ioThreads)
+            : writeAsciiParallel(filename, header, row<uint16_t>(0).data(), stride,
+                                 samplesPerRow, height, 3, ioThreads);
+        if (!ok) {
+            std::cerr << "Error: No se pudo escribir el archivo " << filename << std::endl;
+        }
+        return ok;
+    }
+    
+    BufferedWriter file;
+    if (!file.open(filename)) {
         std::cerr << "Error: No se pudo crear el archivo " << filename << std::endl;
         return false;
     }
-    
-    // Escribir encabezado
-    file << magicNumber << std::endl;
-    file << "# Generado por PPMImage" << std::endl;
-    file << width << " " << height << std::endl;
-    file << maxVal << std::endl;
+    file.write(header);
     
     // Escribir píxeles
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            file << pixels[i][j].r << " " << pixels[i][j].g << " " << pixels[i][j].b;
-            if (j < width - 1) file << "  ";
+    if (isBinary()) {
+        // Filas sin relleno; 16 bits se guardan en big-endian
+        std::vector<char> encoded(sampleSize == 2 ? samplesPerRow * 2 : 0);
+        for (int i = 0; i < height; i++) {
+            if (sampleSize == 1) {
+                file.write(reinterpret_cast<const char*>(row<uint8_t>(i).data()), samplesPerRow);
+            } else {
+                encodeBinarySamples(row<uint16_t>(i).data(), samplesPerRow, encoded.data());
+                file.write(encoded.data(), encoded.size());
+            }
+        }
+    } else {
+        // Cada fila se formatea directamente en el buffer de escritura
+        for (int i = 0; i < height; i++) {
+            char* line = file.reserve(asciiRowCapacity(samplesPerRow));
+            if (line == nullptr) break;
+            size_t length = (sampleSize == 1)
+                ? formatAsciiRow(row<uint8_t>(i).data(), samplesPerRow, 3, line)
+                : formatAsciiRow(row<uint16_t>(i).data(), samplesPerRow, 3, line);
+            file.commit(length);
         }
-        file << std::endl;
     }
     
-    file.close();
+    if (!file.close()) {
+        std::cerr << "Error: No se pudo escribir el archivo " << filename << std::endl;
+        return false;
+    }
     return true;
 }
 
+std::string PPMImage::formatHeader(const std::string& magic, int w, int h, int max) {
+    std::ostringstream header;
+    header << magic << "\n";
+    header << "# Generado por PPMImage" << "\n";
+    header << w << " " << h << "\n";
+    header << max << "\n";
+    return header.str();
+}
+
 RGB PPMImage::getPixel(int x, int y) const {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-        return pixels[y][x];
+        if (sampleSize == 1) {
+            const uint8_t* p = &row<uint8_t>(y)[3 * x];
+            return RGB(p[0], p[1], p[2]);
+        }
+        const uint16_t* p = &row<uint16_t>(y)[3 * x];
+        return RGB(p[0], p[1], p[2]);
     }
     return RGB(0, 0, 0);
 }
@@ -134,7 +231,17 @@ void PPMImage::setPixel(int x, int y, const RGB& color) {
         if (clampedColor.b < 0) clampedColor.b = 0;
         if (clampedColor.b > maxVal) clampedColor.b = maxVal;
         
-        pixels[y][x] = clampedColor;
+        if (sampleSize == 1) {
+            uint8_t* p = &row<uint8_t>(y)[3 * x];
+            p[0] = (uint8_t)clampedColor.r;
+            p[1] = (uint8_t)clampedColor.g;
+            p[2] = (uint8_t)clampedColor.b;
+        } else {
+            uint16_t* p = &row<uint16_t>(y)[3 * x];
+            p[0] = (uint16_t)clampedColor.r;
+            p[1] = (uint16_t)clampedColor.g;
+            p[2] = (uint16_t)clampedColor.b;
+        }
     }
 }
 
@@ -146,32 +253,28 @@ PPMImage* PPMImage::clone() const {
     return new PPMImage(*this);
 }
 
-void PPMImage::allocateMemory() {
+void PPMImage::allocateMemory(bool zeroFill) {
+    ownsPixels = true;
     if (width > 0 && height > 0) {
-        pixels = new RGB*[height];
-        for (int i = 0; i < height; i++) {
-            pixels[i] = new RGB[width];
-            // Los píxeles se inicializan automáticamente con RGB(0,0,0)
-        }
+        sampleSize = sampleSizeFor(maxVal);
+        stride = alignedStride(3 * width, sampleSize) * sampleSize;
+        size_t bytes = (size_t)stride * height;
+        pixels = static_cast<unsigned char*>(allocateAligned(bytes));
+        // Inicializar con RGB(0,0,0) (incluye el relleno)
+        if (zeroFill) memset(pixels, 0, bytes);
     }
 }
 
 void PPMImage::deallocateMemory() {
     if (pixels != nullptr) {
-        for (int i = 0; i < height; i++) {
-            delete[] pixels[i];
-        }
-        delete[] pixels;
+        if (ownsPixels) freeAligned(pixels);
         pixels = nullptr;
     }
 }
 
 void PPMImage::copyPixels(const PPMImage& other) {
     if (pixels != nullptr && other.pixels != nullptr) {
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                pixels[i][j] = other.pixels[i][j];
-            }
-        }
+        // Mismas dimensiones implican el mismo stride: una sola copia
+        memcpy(pixels, other.pixels, (size_t)stride * height);
     }
 }
\ No newline at end of file
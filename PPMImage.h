@@ -3,6 +3,7 @@
 
 #include "Image.h"
 
+// Valor de un píxel RGB (la imagen almacena las muestras con el tamaño de getSampleSize())
 struct RGB {
     int r, g, b;
     
@@ -12,12 +13,22 @@ struct RGB {
 
 class PPMImage : public Image {
 private:
-    RGB** pixels;  // Matriz de píxeles RGB
+    unsigned char* pixels;  // Buffer contiguo de muestras R,G,B intercaladas (fila mayor, alineado a 64 bytes)
+    int stride;             // Bytes por fila, incluyendo el relleno de alineación
+    bool ownsPixels;        // false si el buffer es externo (no se libera)
     
 public:
     // Constructor
     PPMImage();
-    PPMImage(int w, int h, int max);
+    // Con zeroFill == false el buffer no se inicializa: el llamador debe
+    // escribir todas las muestras, y la primera escritura de cada página
+    // decide en qué nodo NUMA queda (first-touch)
+    PPMImage(int w, int h, int max, bool zeroFill = true);
+    // Imagen sobre un buffer externo alineado a PIXEL_ALIGNMENT de al menos
+    // bufferBytes(w, h, max) bytes (p. ej. una ventana de memoria compartida
+    // de MPI). El buffer no se inicializa ni se libera con la imagen
+    PPMImage(int w, int h, int max, unsigned char* buffer);
+    static size_t bufferBytes(int w, int h, int max);
     
     // Destructor
     ~PPMImage();
@@ -31,18 +42,33 @@ public:
     // Implementación de métodos virtuales
     bool readFromFile(const std::string& filename) override;
     bool writeToFile(const std::string& filename) const override;
+    bool readFromMemory(const MappedFile& file, const ImageHeader& header) override;
+    
+    // Encabezado que escribe writeToFile (también lo usa la escritura paralela con MPI-IO)
+    static std::string formatHeader(const std::string& magic, int w, int h, int max);
     
     // Métodos específicos de PPM
     RGB getPixel(int x, int y) const;
     void setPixel(int x, int y, const RGB& color);
     void setPixel(int x, int y, int r, int g, int b);
     
+    // Acceso directo a la fila y (width * 3 muestras R,G,B intercaladas) sin verificación de límites,
+    // para recorridos masivos en filtros y E/S. T debe ser uint8_t si
+    // getSampleSize() == 1 y uint16_t si getSampleSize() == 2
+    template <typename T>
+    RowView<T> row(int y) { return RowView<T>(reinterpret_cast<T*>(pixels + (size_t)y * stride), (size_t)width * 3); }
+    template <typename T>
+    RowView<const T> row(int y) const {
+        return RowView<const T>(reinterpret_cast<const T*>(pixels + (size_t)y * stride), (size_t)width * 3);
+    }
+    int getStride() const { return stride; }
+    
     // Método para crear copia
     PPMImage* clone() const;
     
 private:
     // Métodos auxiliares
-    void allocateMemory();
+    void allocateMemory(bool zeroFill = true);
     void deallocateMemory();
     void copyPixels(const PPMImage& other);
 };
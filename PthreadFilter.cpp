@@ -2,10 +2,51 @@
 #include "PGMImage.h"
 #include "PPMImage.h"
 #include <iostream>
-#include <cmath>
-#include <cstring>
 #include <algorithm>
 
+ThreadPool* PthreadFilter::pool = nullptr;
+int PthreadFilter::poolRequested = 0;
+int PthreadFilter::numThreads = 0;
+int PthreadFilter::tileSize = 0;
+
+void PthreadFilter::setNumThreads(int threads) {
+    numThreads = threads > 0 ? threads : 0;
+}
+
+int PthreadFilter::getNumThreads() {
+    return numThreads > 0 ? numThreads : ThreadPool::hardwareThreads();
+}
+
+void PthreadFilter::setTileSize(int size) {
+    tileSize = size > 0 ? size : 0;
+}
+
+int PthreadFilter::getTileSize(const Image* image) {
+    return tileSize > 0 ? tileSize : defaultTileSize(image);
+}
+
+ThreadPool& PthreadFilter::getPool() {
+    // Se compara con lo pedido, no con lo creado: si no se pudieron crear
+    // todos los hilos, se reutiliza el pool parcial en vez de recrearlo
+    int requested = getNumThreads();
+    if (pool == nullptr || poolRequested != requested) {
+        delete pool;
+        pool = new ThreadPool(requested);
+        poolRequested = requested;
+        if (pool->getNumThreads() < requested) {
+            std::cerr << "Advertencia: El pool solo tiene " << pool->getNumThreads()
+                      << " de " << requested << " hilos" << std::endl;
+        }
+    }
+    return *pool;
+}
+
+void PthreadFilter::shutdown() {
+    delete pool;
+    pool = nullptr;
+    poolRequested = 0;
+}
+
 Image* PthreadFilter::applyFilterParallel(const Image* input, Filter* filter) {
     if (!input || !filter) return nullptr;
     
@@ -22,173 +63,105 @@ Image* PthreadFilter::applyFilterParallel(const Image* input, Filter* filter) {
         return nullptr;
     }
     
-    // Configurar 4 hilos para 4 regiones
-    const int NUM_THREADS = 4;
-    pthread_t threads[NUM_THREADS];
-    ThreadData threadData[NUM_THREADS];
-    
-    int width = input->getWidth();
-    int height = input->getHeight();
-    int halfWidth = width / 2;
-    int halfHeight = height / 2;
-    
-    // Configurar datos para cada hilo
-    // Región 1: Arriba-izquierda
-    threadData[0] = {input, output, filter, 0, halfWidth, 0, halfHeight, 0};
-    
-    // Región 2: Arriba-derecha
-    threadData[1] = {input, output, filter, halfWidth, width, 0, halfHeight, 1};
-    
-    // Región 3: Abajo-izquierda
-    threadData[2] = {input, output, filter, 0, halfWidth, halfHeight, height, 2};
-    
-    // Región 4: Abajo-derecha
-    threadData[3] = {input, output, filter, halfWidth, width, halfHeight, height, 3};
-    
-    std::cout << "Dividiendo imagen en 4 regiones para procesamiento paralelo:" << std::endl;
-    std::cout << "  Región 1 (Arriba-izquierda): (" << 0 << "," << 0 << ") a (" << halfWidth << "," << halfHeight << ")" << std::endl;
-    std::cout << "  Región 2 (Arriba-derecha): (" << halfWidth << "," << 0 << ") a (" << width << "," << halfHeight << ")" << std::endl;
-    std::cout << "  Región 3 (Abajo-izquierda): (" << 0 << "," << halfHeight << ") a (" << halfWidth << "," << height << ")" << std::endl;
-    std::cout << "  Región 4 (Abajo-derecha): (" << halfWidth << "," << halfHeight << ") a (" << width << "," << height << ")" << std::endl;
+    // Determinar el kernel según el tipo de filtro (aritmética entera si el kernel lo permite)
+    ThreadData data;
+    if (!getFilterKernel(filter->getName(), data.kernel)) {
+        delete output;
+        return nullptr;
+    }
     
-    // Crear hilos
-    for (int i = 0; i < NUM_THREADS; i++) {
-        int result = pthread_create(&threads[i], nullptr, threadFunction, &threadData[i]);
-        if (result != 0) {
-            std::cerr << "Error al crear hilo " << i << std::endl;
-            delete output;
-            return nullptr;
+    ThreadPool& threads = getPool();
+    int workers = threads.getNumThreads();
+    int size = getTileSize(input);
+    data.inputImage = input;
+    data.outputImage = output;
+    data.tileWidth = std::max(1, std::min(size, input->getWidth()));
+    data.tileHeight = std::max(1, std::min(size, input->getHeight()));
+    data.tilesPerRow = (input->getWidth() + data.tileWidth - 1) / data.tileWidth;
+    int tileRows = (input->getHeight() + data.tileHeight - 1) / data.tileHeight;
+    int numTiles = data.tilesPerRow * tileRows;
+    
+    // Reparto inicial: un bloque contiguo de teselas (en orden de filas) por
+    // hilo. Se apilan al revés para que el dueño las saque en orden y los
+    // ladrones se lleven las del extremo opuesto de su bloque
+    data.queues.resize(workers);
+    for (int w = 0; w < workers; w++) {
+        int first = (int)((long long)numTiles * w / workers);
+        int last = (int)((long long)numTiles * (w + 1) / workers);
+        data.queues[w] = new WorkStealingDeque(std::max(1, last - first));
+        for (int tile = last - 1; tile >= first; tile--) {
+            data.queues[w]->push(tile);
         }
     }
+    data.tilesPerThread.assign(workers, 0);
+    data.stolenPerThread.assign(workers, 0);
     
-    // Esperar a que terminen todos los hilos
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], nullptr);
-    }
+    std::cout << "Dividiendo imagen en " << numTiles << " teselas de " << data.tileWidth << "x"
+              << data.tileHeight << " para " << workers << " hilos (con robo de trabajo)" << std::endl;
+    
+    threads.runOnEachWorker(tileWorker, &data);
     
-    std::cout << "Procesamiento paralelo completado con " << NUM_THREADS << " hilos" << std::endl;
+    for (int w = 0; w < workers; w++) {
+        delete data.queues[w];
+        std::cout << "  Hilo " << w << ": " << data.tilesPerThread[w] << " teselas ("
+                  << data.stolenPerThread[w] << " robadas)" << std::endl;
+    }
+    std::cout << "Procesamiento paralelo completado con " << workers << " hilos" << std::endl;
     return output;
 }
 
-void* PthreadFilter::threadFunction(void* arg) {
-    ThreadData* data = static_cast<ThreadData*>(arg);
-    
-    std::cout << "Hilo " << data->threadId << " procesando región (" 
-              << data->startX << "," << data->startY << ") a (" 
-              << data->endX << "," << data->endY << ")" << std::endl;
+void PthreadFilter::filterTile(const ThreadData* data, int tile) {
+    int startX = (tile % data->tilesPerRow) * data->tileWidth;
+    int startY = (tile / data->tilesPerRow) * data->tileHeight;
+    int endX = std::min(startX + data->tileWidth, data->inputImage->getWidth());
+    int endY = std::min(startY + data->tileHeight, data->inputImage->getHeight());
     
-    applyFilterToRegion(data->inputImage, data->outputImage, data->filter,
-                       data->startX, data->endX, data->startY, data->endY);
-    
-    std::cout << "Hilo " << data->threadId << " completado" << std::endl;
-    return nullptr;
+    convolveRegion(data->inputImage, data->outputImage, data->kernel, startX, endX, startY, endY);
 }
 
-void PthreadFilter::applyFilterToRegion(const Image* input, Image* output, Filter* filter,
-                                      int startX, int endX, int startY, int endY) {
-    const PGMImage* pgmInput = dynamic_cast<const PGMImage*>(input);
-    const PPMImage* ppmInput = dynamic_cast<const PPMImage*>(input);
-    PGMImage* pgmOutput = dynamic_cast<PGMImage*>(output);
-    PPMImage* ppmOutput = dynamic_cast<PPMImage*>(output);
-    
-    // Determinar el kernel según el tipo de filtro
-    double kernel[3][3];
-    bool isLaplacian = false;
-    
-    if (strcmp(filter->getName(), "Blur") == 0) {
-        double blurKernel[3][3] = {
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0},
-            {1.0/9.0, 1.0/9.0, 1.0/9.0}
-        };
-        memcpy(kernel, blurKernel, sizeof(kernel));
-    } else if (strcmp(filter->getName(), "Laplacian") == 0) {
-        double laplacianKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  4, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, laplacianKernel, sizeof(kernel));
-        isLaplacian = true;
-    } else if (strcmp(filter->getName(), "Sharpen") == 0) {
-        double sharpenKernel[3][3] = {
-            { 0, -1,  0},
-            {-1,  5, -1},
-            { 0, -1,  0}
-        };
-        memcpy(kernel, sharpenKernel, sizeof(kernel));
-    }
-    
-    // Aplicar filtro a la región asignada
-    for (int y = startY; y < endY; y++) {
-        for (int x = startX; x < endX; x++) {
-            if (pgmInput && pgmOutput) {
-                // Procesar imagen PGM
-                double sum = 0;
-                
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        // Manejo de bordes
-                        if (px < 0) px = 0;
-                        if (px >= input->getWidth()) px = input->getWidth() - 1;
-                        if (py < 0) py = 0;
-                        if (py >= input->getHeight()) py = input->getHeight() - 1;
-                        
-                        int pixel = pgmInput->getPixel(px, py);
-                        sum += pixel * kernel[ky + 1][kx + 1];
-                    }
-                }
-                
-                int result = (int)std::round(sum);
-                if (isLaplacian) {
-                    result += 128; // Centrar resultado para Laplaciano
-                }
-                result = std::max(0, std::min(input->getMaxVal(), result));
-                pgmOutput->setPixel(x, y, result);
-                
-            } else if (ppmInput && ppmOutput) {
-                // Procesar imagen PPM
-                double sumR = 0, sumG = 0, sumB = 0;
-                
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        int px = x + kx;
-                        int py = y + ky;
-                        
-                        // Manejo de bordes
-                        if (px < 0) px = 0;
-                        if (px >= input->getWidth()) px = input->getWidth() - 1;
-                        if (py < 0) py = 0;
-                        if (py >= input->getHeight()) py = input->getHeight() - 1;
-                        
-                        RGB pixel = ppmInput->getPixel(px, py);
-                        double kernelValue = kernel[ky + 1][kx + 1];
-                        
-                        sumR += pixel.r * kernelValue;
-                        sumG += pixel.g * kernelValue;
-                        sumB += pixel.b * kernelValue;
-                    }
-                }
-                
-                int r = (int)std::round(sumR);
-                int g = (int)std::round(sumG);
-                int b = (int)std::round(sumB);
-                
-                if (isLaplacian) {
-                    r += 128;
-                    g += 128;
-                    b += 128;
-                }
-                
-                r = std::max(0, std::min(input->getMaxVal(), r));
-                g = std::max(0, std::min(input->getMaxVal(), g));
-                b = std::max(0, std::min(input->getMaxVal(), b));
-                
-                ppmOutput->setPixel(x, y, RGB(r, g, b));
+void PthreadFilter::tileWorker(void* arg, int workerId) {
+    ThreadData* data = static_cast<ThreadData*>(arg);
+    int workers = (int)data->queues.size();
+    WorkStealingDeque* own = data->queues[workerId];
+    int processed = 0;
+    int stolen = 0;
+    int victim = workerId;
+    
+    for (;;) {
+        int tile;
+        if (own->pop(tile)) {
+            filterTile(data, tile);
+            processed++;
+            continue;
+        }
+        
+        // Deque propio vacío: recorrer a los demás hilos a partir del último
+        // al que se le robó. Como nadie agrega teselas durante el filtrado,
+        // una vuelta completa sin robos ni carreras perdidas indica el final
+        bool found = false;
+        bool contended = false;
+        for (int k = 1; k < workers && !found; k++) {
+            int candidate = (victim + k) % workers;
+            if (candidate == workerId) continue;
+            WorkStealingDeque::StealResult result = data->queues[candidate]->steal(tile);
+            if (result == WorkStealingDeque::STEAL_SUCCESS) {
+                found = true;
+                victim = (candidate - 1 + workers) % workers;   // Volver a probar el mismo hilo
+            } else if (result == WorkStealingDeque::STEAL_ABORT) {
+                contended = true;
             }
         }
+        
+        if (found) {
+            filterTile(data, tile);
+            processed++;
+            stolen++;
+        } else if (!contended) {
+            break;
+        }
     }
+    
+    // Cada hilo escribe solo su propia posición
+    data->tilesPerThread[workerId] = processed;
+    data->stolenPerThread[workerId] = stolen;
 }
@@ -2,26 +2,54 @@
 #define PTHREADFILTER_H
 
 #include "Filter.h"
+#include "Convolution.h"
+#include "ThreadPool.h"
+#include "WorkStealingDeque.h"
 #include <pthread.h>
+#include <vector>
 
-// Estructura para pasar datos a los hilos
+// Datos compartidos por los hilos durante una aplicación del filtro
 struct ThreadData {
     const Image* inputImage;
     Image* outputImage;
-    Filter* filter;
-    int startX, endX;  // Región horizontal
-    int startY, endY;  // Región vertical
-    int threadId;
+    Kernel3x3 kernel;
+    int tileWidth;
+    int tileHeight;
+    int tilesPerRow;
+    std::vector<WorkStealingDeque*> queues;   // Teselas pendientes de cada hilo
+    std::vector<int> tilesPerThread;          // Teselas procesadas por cada hilo
+    std::vector<int> stolenPerThread;         // De ellas, cuántas robó a otro hilo
 };
 
 class PthreadFilter {
 public:
+    // Número de hilos del pool (por defecto, los hilos de la máquina). Si
+    // cambia, el pool se vuelve a crear en la siguiente aplicación
+    static void setNumThreads(int threads);
+    static int getNumThreads();
+    
+    // Lado de las teselas en píxeles; 0 (por defecto) lo elige según el
+    // tamaño de píxel para que entrada y salida de una tesela quepan en L2
+    static void setTileSize(int size);
+    static int getTileSize(const Image* image);
+    
+    // Aplica el filtro por teselas: cada hilo empieza con un bloque contiguo
+    // de teselas en su propio deque y, al vaciarlo, roba teselas de los demás.
+    // Los hilos del pool se crean una sola vez y se reutilizan
     static Image* applyFilterParallel(const Image* input, Filter* filter);
     
+    // Termina los hilos del pool
+    static void shutdown();
+    
 private:
-    static void* threadFunction(void* arg);
-    static void applyFilterToRegion(const Image* input, Image* output, Filter* filter,
-                                  int startX, int endX, int startY, int endY);
+    static ThreadPool* pool;
+    static int poolRequested;    // Hilos pedidos al crear el pool actual
+    static int numThreads;
+    static int tileSize;
+    
+    static ThreadPool& getPool();
+    static void filterTile(const ThreadData* data, int tile);
+    static void tileWorker(void* arg, int workerId);
 };
 
 #endif // PTHREADFILTER_H
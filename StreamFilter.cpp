@@ -0,0 +1,164 @@
+#include "StreamFilter.h"
+#include "Image.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+StreamFilter::StreamFilter(const Kernel3x3& k, int rows)
+    : kernel(k), bandRows(rows > 0 ? rows : 1), width(0), height(0), maxVal(0), channels(1),
+      sampleSize(1), samplesPerRow(0), rowBytes(0), windowRows(0), bandIndex(0), bandStart(0),
+      nextRead(0), readTarget(0), pendingBand(-1), pendingRows(0), readFailed(false),
+      failedRow(0), failedSample(0), writeFailed(false) {}
+
+bool StreamFilter::run(const std::string& inputFilename, const std::string& outputFilename, int outputBinary) {
+    if (!reader.open(inputFilename)) {
+        std::cerr << "Error: No se pudo abrir el archivo " << inputFilename << std::endl;
+        return false;
+    }
+    const ImageHeader& header = reader.getHeader();
+    
+    // Validar el encabezado con los mismos criterios que readFromMemory
+    std::string magic = header.magicNumber;
+    if (magic != "P2" && magic != "P3" && magic != "P5" && magic != "P6") {
+        std::cerr << "Error: Formato de archivo no soportado. Número mágico: " << magic << std::endl;
+        return false;
+    }
+    width = header.width;
+    height = header.height;
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Error: Dimensiones inválidas: " << width << " x " << height << std::endl;
+        return false;
+    }
+    maxVal = header.maxVal;
+    if (maxVal <= 0 || maxVal > MAX_SAMPLE_VALUE) {
+        std::cerr << "Error: Valor máximo inválido: " << maxVal << std::endl;
+        return false;
+    }
+    
+    bool color = (magic == "P3" || magic == "P6");
+    bool binary = outputBinary < 0 ? (magic == "P5" || magic == "P6") : outputBinary == 1;
+    channels = color ? 3 : 1;
+    sampleSize = Image::sampleSizeFor(maxVal);
+    samplesPerRow = (size_t)width * channels;
+    rowBytes = samplesPerRow * sampleSize;
+    
+    // Encabezado de salida idéntico al de PGMImage/PPMImage::writeToFile
+    std::ostringstream outHeader;
+    outHeader << (color ? (binary ? "P6" : "P3") : (binary ? "P5" : "P2")) << "\n";
+    outHeader << "# Generado por " << (color ? "PPMImage" : "PGMImage") << "\n";
+    outHeader << width << " " << height << "\n";
+    outHeader << maxVal << "\n";
+    
+    if (!writer.open(outputFilename, outHeader.str(), binary, channels)) {
+        std::cerr << "Error: No se pudo crear el archivo " << outputFilename << std::endl;
+        return false;
+    }
+    
+    windowRows = 2 * bandRows + 2;
+    window.assign((size_t)windowRows * rowBytes, 0);
+    output.assign((size_t)2 * bandRows * rowBytes, 0);
+    
+    // Primera banda: sus filas y la vecina inferior
+    nextRead = 0;
+    readTarget = std::min(bandRows + 1, height);
+    pendingBand = -1;
+    readFailed = writeFailed = false;
+    readRows();
+    
+    bool ok = !readFailed;
+    for (bandIndex = 0; ok && (bandStart = bandIndex * bandRows) < height; bandIndex++) {
+        int rowsInBand = std::min(bandRows, height - bandStart);
+        
+        // Mientras se filtra la banda actual se escribe la anterior y se leen
+        // las filas que necesitará la siguiente
+        readTarget = std::min(bandStart + 2 * bandRows + 1, height);
+        runStep(rowsInBand);
+        
+        ok = !readFailed && !writeFailed;
+        pendingBand = bandIndex;
+        pendingRows = rowsInBand;
+    }
+    
+    // Última banda
+    if (ok) {
+        writePending();
+        ok = !writeFailed;
+    }
+    
+    if (readFailed) {
+        if (color) {
+            std::cerr << "Error: Error al leer píxel RGB en posición (" << failedRow << ", " << failedSample / 3 << ")" << std::endl;
+        } else {
+            std::cerr << "Error: Error al leer píxel en posición (" << failedRow << ", " << failedSample << ")" << std::endl;
+        }
+    }
+    
+    bool closed = writer.close();
+    if (readFailed) {
+        // No dejar una salida incompleta
+        std::remove(outputFilename.c_str());
+        return false;
+    }
+    if (!closed || writeFailed) {
+        std::cerr << "Error: No se pudo escribir el archivo " << outputFilename << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+void StreamFilter::runStep(int rowsInBand) {
+    transferIO();
+    for (int i = 0; i < rowsInBand; i++) {
+        filterRow(i);
+    }
+}
+
+void StreamFilter::transferIO() {
+    if (pendingBand >= 0) {
+        writePending();
+    }
+    readRows();
+}
+
+void StreamFilter::readRows() {
+    while (!readFailed && nextRead < readTarget) {
+        unsigned char* row = windowRow(nextRead);
+        size_t read = (sampleSize == 1)
+            ? reader.readRow(reinterpret_cast<uint8_t*>(row), samplesPerRow)
+            : reader.readRow(reinterpret_cast<uint16_t*>(row), samplesPerRow);
+        if (read < samplesPerRow) {
+            readFailed = true;
+            failedRow = nextRead;
+            failedSample = read;
+        }
+        nextRead++;
+    }
+}
+
+void StreamFilter::writePending() {
+    for (int i = 0; i < pendingRows && !writeFailed; i++) {
+        unsigned char* row = outputRow(pendingBand, i);
+        bool written = (sampleSize == 1)
+            ? writer.writeRow(reinterpret_cast<const uint8_t*>(row), samplesPerRow)
+            : writer.writeRow(reinterpret_cast<const uint16_t*>(row), samplesPerRow);
+        writeFailed = !written;
+    }
+    pendingBand = -1;
+}
+
+void StreamFilter::filterRow(int index) {
+    int y = bandStart + index;
+    const unsigned char* above = windowRow(y > 0 ? y - 1 : 0);
+    const unsigned char* current = windowRow(y);
+    const unsigned char* below = windowRow(y + 1 < height ? y + 1 : height - 1);
+    unsigned char* out = outputRow(bandIndex, index);
+    
+    if (sampleSize == 1) {
+        convolveRow(above, current, below, out, width, channels, kernel, maxVal);
+    } else {
+        convolveRow(reinterpret_cast<const uint16_t*>(above), reinterpret_cast<const uint16_t*>(current),
+                    reinterpret_cast<const uint16_t*>(below), reinterpret_cast<uint16_t*>(out),
+                    width, channels, kernel, maxVal);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef STREAMFILTER_H
+#define STREAMFILTER_H
+
+#include "Convolution.h"
+#include "ImageIO.h"
+#include <string>
+#include <vector>
+
+// Filtrado en modo streaming: la imagen se lee por filas, solo se mantiene una
+// ventana deslizante de filas de entrada y cada banda de salida se escribe en
+// cuanto está lista. La memoria es O(ancho * filas por banda), independiente
+// de la altura de la imagen
+class StreamFilter {
+public:
+    StreamFilter(const Kernel3x3& kernel, int bandRows = 1);
+    virtual ~StreamFilter() {}
+    
+    // outputBinary: 1 binario (P5/P6), 0 ASCII (P2/P3), -1 igual que la entrada
+    bool run(const std::string& inputFilename, const std::string& outputFilename, int outputBinary);
+    
+    // Datos del encabezado de la última imagen procesada
+    const ImageHeader& getHeader() const { return reader.getHeader(); }
+    
+protected:
+    // Un paso del pipeline: transferIO() y filterRow(i) para cada fila de la
+    // banda actual. La versión base los ejecuta uno tras otro; las subclases
+    // pueden solaparlos (escriben y leen filas distintas de las que se filtran)
+    virtual void runStep(int rowsInBand);
+    
+    // Escribe la banda anterior y lee las filas de entrada de la siguiente
+    void transferIO();
+    // Filtra la fila 'index' de la banda actual
+    void filterRow(int index);
+    
+private:
+    Kernel3x3 kernel;
+    int bandRows;
+    
+    RowReader reader;
+    RowWriter writer;
+    
+    int width;
+    int height;
+    int maxVal;
+    int channels;
+    int sampleSize;
+    size_t samplesPerRow;
+    size_t rowBytes;
+    
+    // Ventana circular de 2 * bandRows + 2 filas de entrada: la banda actual
+    // con sus vecinas y las filas que se leen mientras se filtra
+    std::vector<unsigned char> window;
+    int windowRows;
+    // Dos bandas de salida: una se filtra mientras la otra se escribe
+    std::vector<unsigned char> output;
+    
+    // Estado del paso actual
+    int bandIndex;
+    int bandStart;
+    int nextRead;       // Siguiente fila de entrada a leer
+    int readTarget;     // Leer hasta esta fila (exclusiva) en transferIO
+    int pendingBand;    // Banda pendiente de escribir (-1 si no hay)
+    int pendingRows;
+    
+    // Errores detectados en transferIO
+    bool readFailed;
+    int failedRow;
+    size_t failedSample;
+    bool writeFailed;
+    
+    unsigned char* windowRow(int y) { return &window[(size_t)(y % windowRows) * rowBytes]; }
+    unsigned char* outputRow(int band, int index) {
+        return &output[((size_t)(band % 2) * bandRows + index) * rowBytes];
+    }
+    void readRows();
+    void writePending();
+};
+
+#endif // STREAMFILTER_H
@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+#include <thread>
+#include <iostream>
+
+ThreadPool::ThreadPool(int numThreads)
+    : task(nullptr), taskArg(nullptr), activeWorkers(0), generation(0), stopping(false) {
+    if (numThreads < 1) numThreads = 1;
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&workReady, nullptr);
+    pthread_cond_init(&workDone, nullptr);
+    
+    // Las direcciones de 'starts' deben ser estables antes de crear los hilos
+    starts.resize(numThreads - 1);
+    threads.reserve(numThreads - 1);
+    for (int i = 1; i < numThreads; i++) {
+        starts[i - 1].pool = this;
+        starts[i - 1].workerId = i;
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, workerMain, &starts[i - 1]) != 0) {
+            std::cerr << "Error al crear hilo " << i << std::endl;
+            break;
+        }
+        threads.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_broadcast(&workReady);
+    pthread_mutex_unlock(&mutex);
+    
+    for (size_t i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], nullptr);
+    }
+    
+    pthread_cond_destroy(&workDone);
+    pthread_cond_destroy(&workReady);
+    pthread_mutex_destroy(&mutex);
+}
+
+int ThreadPool::hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? (int)count : 1;
+}
+
+void ThreadPool::runOnEachWorker(PoolTask function, void* arg) {
+    pthread_mutex_lock(&mutex);
+    task = function;
+    taskArg = arg;
+    activeWorkers = (int)threads.size();
+    generation++;
+    pthread_cond_broadcast(&workReady);
+    pthread_mutex_unlock(&mutex);
+    
+    // El hilo que llama trabaja como hilo 0
+    function(arg, 0);
+    
+    pthread_mutex_lock(&mutex);
+    while (activeWorkers > 0) {
+        pthread_cond_wait(&workDone, &mutex);
+    }
+    task = nullptr;
+    pthread_mutex_unlock(&mutex);
+}
+
+void* ThreadPool::workerMain(void* arg) {
+    WorkerStart* start = static_cast<WorkerStart*>(arg);
+    ThreadPool* pool = start->pool;
+    unsigned seen = 0;
+    
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->workReady, &pool->mutex);
+        }
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        seen = pool->generation;
+        PoolTask function = pool->task;
+        void* taskArg = pool->taskArg;
+        pthread_mutex_unlock(&pool->mutex);
+        
+        function(taskArg, start->workerId);
+        
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->activeWorkers == 0) {
+            pthread_cond_signal(&pool->workDone);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return nullptr;
+}
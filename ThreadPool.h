@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <vector>
+
+// Tarea ejecutada por el pool: recibe el argumento común y el identificador
+// del hilo que la ejecuta (0..getNumThreads()-1)
+typedef void (*PoolTask)(void* arg, int workerId);
+
+// Pool de hilos persistente: los hilos se crean una sola vez y esperan
+// trabajo entre llamadas a runOnEachWorker(). El hilo que llama también
+// trabaja (como hilo 0), así que se crean numThreads - 1 hilos
+class ThreadPool {
+private:
+    std::vector<pthread_t> threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t workReady;
+    pthread_cond_t workDone;
+    
+    // Trabajo actual (protegido por mutex)
+    PoolTask task;
+    void* taskArg;
+    int activeWorkers;       // Hilos del pool que aún no terminan el trabajo actual
+    unsigned generation;     // Cambia con cada llamada a runOnEachWorker()
+    bool stopping;
+    
+public:
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+    
+    // Hilos realmente disponibles: puede ser menor que el pedido si no se
+    // pudieron crear todos
+    int getNumThreads() const { return (int)threads.size() + 1; }
+    
+    // Ejecuta function(arg, worker) exactamente una vez en cada hilo, para
+    // que cada uno organice su propio trabajo (p. ej. robo de tareas).
+    // Bloquea hasta que terminan todos
+    void runOnEachWorker(PoolTask function, void* arg);
+    
+    // Hilos disponibles en la máquina (al menos 1)
+    static int hardwareThreads();
+    
+private:
+    struct WorkerStart {
+        ThreadPool* pool;
+        int workerId;
+    };
+    std::vector<WorkerStart> starts;
+    
+    static void* workerMain(void* arg);
+    
+    // No copiable
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif // THREADPOOL_H
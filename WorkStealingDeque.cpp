@@ -0,0 +1,67 @@
+#include "WorkStealingDeque.h"
+
+// Órdenes de memoria según Lê et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models" (PPoPP 2013)
+
+WorkStealingDeque::WorkStealingDeque(size_t size)
+    : items(new std::atomic<int>[size > 0 ? size : 1]), capacity(size > 0 ? (long)size : 1),
+      top(0), bottom(0) {
+}
+
+WorkStealingDeque::~WorkStealingDeque() {
+    delete[] items;
+}
+
+bool WorkStealingDeque::push(int item) {
+    long b = bottom.load(std::memory_order_relaxed);
+    long t = top.load(std::memory_order_acquire);
+    if (b - t >= capacity) return false;
+    
+    items[b % capacity].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingDeque::pop(int& item) {
+    long b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long t = top.load(std::memory_order_relaxed);
+    
+    if (t > b) {
+        // Vacío
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    item = items[b % capacity].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Último elemento: se disputa con los ladrones
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+WorkStealingDeque::StealResult WorkStealingDeque::steal(int& item) {
+    long t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return STEAL_EMPTY;
+    
+    int value = items[t % capacity].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+        return STEAL_ABORT;
+    }
+    item = value;
+    return STEAL_SUCCESS;
+}
+
+void WorkStealingDeque::clear() {
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(0, std::memory_order_relaxed);
+}
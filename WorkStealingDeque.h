@@ -0,0 +1,46 @@
+#ifndef WORKSTEALINGDEQUE_H
+#define WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Deque de Chase-Lev de capacidad fija para índices de tareas. El hilo dueño
+// agrega y saca por abajo (push/pop, LIFO) sin bloqueos; los demás hilos roban
+// por arriba (steal, FIFO) con una comparación atómica sobre 'top'
+class WorkStealingDeque {
+public:
+    enum StealResult {
+        STEAL_EMPTY,     // No había tareas
+        STEAL_ABORT,     // Otro hilo ganó la carrera; puede reintentarse
+        STEAL_SUCCESS
+    };
+    
+    explicit WorkStealingDeque(size_t capacity);
+    ~WorkStealingDeque();
+    
+    // Solo el hilo dueño. push devuelve false si el deque está lleno
+    bool push(int item);
+    bool pop(int& item);
+    
+    // Cualquier hilo
+    StealResult steal(int& item);
+    
+    // Vacía el deque; solo cuando ningún hilo lo está usando
+    void clear();
+    
+private:
+    std::atomic<int>* items;
+    long capacity;
+    
+    // 'top' y 'bottom' en líneas de caché distintas: los ladrones solo
+    // escriben 'top' y el dueño casi siempre solo 'bottom'
+    std::atomic<long> top;
+    char padding[64 - sizeof(std::atomic<long>)];
+    std::atomic<long> bottom;
+    
+    // No copiable
+    WorkStealingDeque(const WorkStealingDeque&);
+    WorkStealingDeque& operator=(const WorkStealingDeque&);
+};
+
+#endif // WORKSTEALINGDEQUE_H
@@ -2,24 +2,112 @@
 #include "PGMImage.h"
 #include "PPMImage.h"
 #include "Filter.h"
+#include "Convolution.h"
+#include "StreamFilter.h"
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <cstring>
+#include <cstdlib>
 
 void printUsage(const char* programName) {
-    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro>" << std::endl;
+    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro> [opciones]" << std::endl;
     std::cout << "Ejemplo: " << programName << " fruit.ppm fruit_blur.ppm --f blur" << std::endl;
     std::cout << "\nFormatos soportados:" << std::endl;
-    std::cout << "  - PPM (P3): Imágenes a color" << std::endl;
-    std::cout << "  - PGM (P2): Imágenes en escala de grises" << std::endl;
+    std::cout << "  - PPM (P3/P6): Imágenes a color (ASCII/binario)" << std::endl;
+    std::cout << "  - PGM (P2/P5): Imágenes en escala de grises (ASCII/binario)" << std::endl;
     std::cout << "\nFiltros disponibles:" << std::endl;
     std::cout << "  - blur: Filtro de suavizado" << std::endl;
     std::cout << "  - laplace/laplacian: Filtro Laplaciano (detección de bordes)" << std::endl;
     std::cout << "  - sharpen/sharpening: Filtro de realce" << std::endl;
+    std::cout << "\nOpciones:" << std::endl;
+    std::cout << "  --binary: Guardar la salida en binario (P5/P6)" << std::endl;
+    std::cout << "  --ascii: Guardar la salida en ASCII (P2/P3)" << std::endl;
+    std::cout << "  (por defecto se conserva la codificación del archivo de entrada)" << std::endl;
+    std::cout << "  --io-threads <n>: Hilos para decodificar y formatear archivos ASCII grandes (por defecto 1)" << std::endl;
+    std::cout << "  --stream: Filtrar por bandas de filas con memoria acotada (imágenes muy grandes)" << std::endl;
+    std::cout << "  (--stream lee y escribe de forma secuencial; no admite --io-threads)" << std::endl;
 }
 
-void measureAndApplyFilter(const std::string& inputFilename, const std::string& outputFilename, const char* filterName) {
+// Opciones de línea de comandos posteriores a "--f <filtro>"
+struct Options {
+    int outputBinary;   // 1: P5/P6, 0: P2/P3, -1: misma codificación que la entrada
+    int ioThreads;      // Hilos para decodificar y formatear archivos ASCII
+    bool stream;        // Modo streaming (ventana deslizante de filas)
+    
+    Options() : outputBinary(-1), ioThreads(1), stream(false) {}
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            options.outputBinary = 1;
+        } else if (strcmp(argv[i], "--ascii") == 0) {
+            options.outputBinary = 0;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            options.stream = true;
+        } else if (strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc) {
+            options.ioThreads = atoi(argv[++i]);
+            if (options.ioThreads < 1) {
+                std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Opción no reconocida: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    // El modo streaming lee y escribe fila a fila de forma secuencial
+    if (options.stream && options.ioThreads > 1) {
+        std::cerr << "Error: --io-threads no se combina con --stream" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Modo streaming: lectura, filtrado y escritura por bandas de filas sin
+// cargar la imagen completa
+void measureAndApplyFilterStreaming(const std::string& inputFilename, const std::string& outputFilename, const char* filterName, const Options& options) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Procesando archivo: " << inputFilename << std::endl;
+    std::cout << "Filtro: " << filterName << std::endl;
+    std::cout << "Archivo de salida: " << outputFilename << std::endl;
+    std::cout << "Modo: streaming" << std::endl;
+    std::cout << "========================================" << std::endl;
+    
+    // El kernel se obtiene del filtro, igual que en el modo normal
+    Filter* filter = FilterFactory::createFilter(filterName);
+    Kernel3x3 kernel;
+    if (filter == nullptr || !getFilterKernel(filter->getName(), kernel)) {
+        std::cerr << "Error: Filtro no reconocido: " << filterName << std::endl;
+        delete filter;
+        return;
+    }
+    
+    std::cout << "Aplicando filtro: " << filter->getName() << std::endl;
+    std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
+    
+    StreamFilter streamFilter(kernel);
+    auto start = std::chrono::high_resolution_clock::now();
+    bool success = streamFilter.run(inputFilename, outputFilename, options.outputBinary);
+    auto end = std::chrono::high_resolution_clock::now();
+    
+    auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::cout << "Tiempo total: " << totalTime.count() << " microsegundos" << std::endl;
+    
+    if (success) {
+        const ImageHeader& header = streamFilter.getHeader();
+        std::cout << "Dimensiones: " << header.width << " x " << header.height << std::endl;
+        std::cout << "Imagen filtrada guardada exitosamente en: " << outputFilename << std::endl;
+    } else {
+        std::cerr << "Error al procesar la imagen en modo streaming" << std::endl;
+    }
+    
+    delete filter;
+    std::cout << "Procesamiento completado." << std::endl;
+}
+
+void measureAndApplyFilter(const std::string& inputFilename, const std::string& outputFilename, const char* filterName, const Options& options) {
     std::cout << "\n========================================" << std::endl;
     std::cout << "Procesando archivo: " << inputFilename << std::endl;
     std::cout << "Filtro: " << filterName << std::endl;
@@ -28,7 +116,7 @@ void measureAndApplyFilter(const std::string& inputFilename, const std::string&
     
     // Medir tiempo de carga
     auto startLoad = std::chrono::high_resolution_clock::now();
-    Image* image = ImageFactory::createImage(inputFilename);
+    Image* image = ImageFactory::createImage(inputFilename, options.ioThreads);
     auto endLoad = std::chrono::high_resolution_clock::now();
     
     if (image == nullptr) {
@@ -51,6 +139,7 @@ void measureAndApplyFilter(const std::string& inputFilename, const std::string&
     }
     
     std::cout << "Aplicando filtro: " << filter->getName() << std::endl;
+    std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
     
     // Medir tiempo de aplicación del filtro
     auto startFilter = std::chrono::high_resolution_clock::now();
@@ -67,6 +156,10 @@ void measureAndApplyFilter(const std::string& inputFilename, const std::string&
     auto filterTime = std::chrono::duration_cast<std::chrono::microseconds>(endFilter - startFilter);
     std::cout << "Tiempo de aplicación del filtro: " << filterTime.count() << " microsegundos" << std::endl;
     
+    // Codificación de salida: la solicitada o la de la imagen de entrada
+    filteredImage->setBinary(options.outputBinary < 0 ? image->isBinary() : options.outputBinary == 1);
+    filteredImage->setIOThreads(options.ioThreads);
+    
     // Medir tiempo de guardado
     auto startSave = std::chrono::high_resolution_clock::now();
     bool success = filteredImage->writeToFile(outputFilename);
@@ -96,7 +189,7 @@ int main(int argc, char* argv[]) {
     std::cout << "=== Filtrador de Imágenes PPM/PGM - Versión Secuencial ===" << std::endl;
     std::cout << "Programación Paralela - Parcial 1" << std::endl;
     
-    if (argc != 5) {
+    if (argc < 5) {
         std::cerr << "Error: Número incorrecto de argumentos" << std::endl;
         printUsage(argv[0]);
         return 1;
@@ -113,11 +206,21 @@ int main(int argc, char* argv[]) {
     std::string outputFilename = argv[2];
     const char* filterName = argv[4];
     
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
     // Medir tiempo total de CPU y de pared
     auto cpuStartTime = std::clock();
     auto wallStartTime = std::chrono::high_resolution_clock::now();
     
-    measureAndApplyFilter(inputFilename, outputFilename, filterName);
+    if (options.stream) {
+        measureAndApplyFilterStreaming(inputFilename, outputFilename, filterName, options);
+    } else {
+        measureAndApplyFilter(inputFilename, outputFilename, filterName, options);
+    }
     
     auto cpuEndTime = std::clock();
     auto wallEndTime = std::chrono::high_resolution_clock::now();
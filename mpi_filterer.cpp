@@ -2,26 +2,148 @@
 #include "PGMImage.h"
 #include "PPMImage.h"
 #include "Filter.h"
+#include "Convolution.h"
 #include "MPIFilter.h"
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <set>
 #include <chrono>
+#include <climits>
 #include <cstring>
+#include <cstdlib>
 #include <mpi.h>
+#include <omp.h>
 
 void printUsage(const char* programName) {
-    std::cout << "Uso: mpirun -np <num_procesos> " << programName << " <archivo_entrada> <archivo_salida> --f <filtro>" << std::endl;
+    std::cout << "Uso: mpirun -np <num_procesos> " << programName << " <archivo_entrada> <archivo_salida> --f <filtro> [opciones]" << std::endl;
     std::cout << "Ejemplo: mpirun -np 4 " << programName << " sulfur.pgm sulfur_mpi.pgm --f blur" << std::endl;
     std::cout << "\nFormatos soportados:" << std::endl;
-    std::cout << "  - PPM (P3): Imágenes a color" << std::endl;
-    std::cout << "  - PGM (P2): Imágenes en escala de grises" << std::endl;
+    std::cout << "  - PPM (P3/P6): Imágenes a color (ASCII/binario)" << std::endl;
+    std::cout << "  - PGM (P2/P5): Imágenes en escala de grises (ASCII/binario)" << std::endl;
     std::cout << "\nFiltros disponibles:" << std::endl;
     std::cout << "  - blur: Filtro de suavizado" << std::endl;
     std::cout << "  - laplace/laplacian: Filtro Laplaciano (detección de bordes)" << std::endl;
     std::cout << "  - sharpen/sharpening: Filtro de realce" << std::endl;
+    std::cout << "\nOpciones:" << std::endl;
+    std::cout << "  --binary: Guardar la salida en binario (P5/P6)" << std::endl;
+    std::cout << "  --ascii: Guardar la salida en ASCII (P2/P3)" << std::endl;
+    std::cout << "  (por defecto se conserva la codificación del archivo de entrada)" << std::endl;
+    std::cout << "  --io-threads <n>: Hilos para decodificar y formatear archivos ASCII grandes (por defecto 1)" << std::endl;
+    std::cout << "  --overlap: Solapar el intercambio de halos con el filtrado de las filas interiores" << std::endl;
+    std::cout << "  --threads <n>: Modo híbrido MPI + OpenMP con n hilos por proceso (por defecto 1)" << std::endl;
+    std::cout << "  --threads auto: Hilos según OMP_NUM_THREADS de cada proceso" << std::endl;
+    std::cout << "  --2d: Reparto 2D por bloques en una malla cartesiana de procesos elegida según la forma de la imagen" << std::endl;
+    std::cout << "  --shm: Entrada y salida en memoria compartida entre los procesos de cada nodo (solo hay mensajes entre nodos)" << std::endl;
+    std::cout << "  --iterations <n>: Aplicar el filtro n veces seguidas (halos con solicitudes persistentes)" << std::endl;
+    std::cout << "  --batch: Modo por lotes: <archivo_entrada> es una lista de imágenes (una por línea) y <archivo_salida>" << std::endl;
+    std::cout << "           un directorio existente; el proceso 0 reparte las imágenes entre los demás bajo demanda." << std::endl;
+    std::cout << "           Termina con código 1 si alguna imagen no se pudo filtrar o guardar" << std::endl;
+    std::cout << "  (lo habitual es un proceso por nodo o por socket: mpirun --map-by ppr:1:node --bind-to none)" << std::endl;
+}
+
+// Opciones de línea de comandos posteriores a "--f <filtro>"
+struct Options {
+    int outputBinary;   // 1: P5/P6, 0: P2/P3, -1: misma codificación que la entrada
+    int ioThreads;      // Hilos para decodificar y formatear archivos ASCII
+    bool overlap;       // Intercambio de halos no bloqueante solapado con el filtrado
+    int threads;        // Hilos OpenMP por proceso (1: solo MPI, 0: omp_get_max_threads())
+    bool blocks2D;      // Reparto 2D por bloques (MPI_Cart_create) en lugar de por filas
+    bool sharedMemory;  // Bloques compartidos por nodo (MPI_Win_allocate_shared)
+    bool batch;         // Lista de imágenes independientes repartidas bajo demanda
+    int iterations;     // Pasadas del filtro sobre el resultado de la anterior
+    
+    Options() : outputBinary(-1), ioThreads(1), overlap(false), threads(1), blocks2D(false),
+                sharedMemory(false), batch(false), iterations(1) {}
+};
+
+bool parseOptions(int argc, char* argv[], Options& options, int rank) {
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            options.outputBinary = 1;
+        } else if (strcmp(argv[i], "--ascii") == 0) {
+            options.outputBinary = 0;
+        } else if (strcmp(argv[i], "--overlap") == 0) {
+            options.overlap = true;
+        } else if (strcmp(argv[i], "--2d") == 0) {
+            options.blocks2D = true;
+        } else if (strcmp(argv[i], "--shm") == 0) {
+            options.sharedMemory = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            options.batch = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            i++;
+            options.threads = strcmp(argv[i], "auto") == 0 ? 0 : atoi(argv[i]);
+            if (options.threads < 1 && strcmp(argv[i], "auto") != 0) {
+                if (rank == 0) {
+                    std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                }
+                return false;
+            }
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options.iterations = atoi(argv[++i]);
+            if (options.iterations < 1) {
+                if (rank == 0) {
+                    std::cerr << "Error: Número de iteraciones inválido: " << argv[i] << std::endl;
+                }
+                return false;
+            }
+        } else if (strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc) {
+            options.ioThreads = atoi(argv[++i]);
+            if (options.ioThreads < 1) {
+                if (rank == 0) {
+                    std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                }
+                return false;
+            }
+        } else {
+            if (rank == 0) {
+                std::cerr << "Error: Opción no reconocida: " << argv[i] << std::endl;
+            }
+            return false;
+        }
+    }
+    
+    if (options.blocks2D && options.sharedMemory) {
+        if (rank == 0) {
+            std::cerr << "Error: --2d y --shm no se pueden combinar" << std::endl;
+        }
+        return false;
+    }
+    if (options.batch && (options.blocks2D || options.sharedMemory || options.overlap)) {
+        if (rank == 0) {
+            std::cerr << "Error: --batch no se combina con --2d, --shm ni --overlap" << std::endl;
+        }
+        return false;
+    }
+    if (options.iterations > 1 && (options.blocks2D || options.sharedMemory || options.batch)) {
+        if (rank == 0) {
+            std::cerr << "Error: --iterations solo se aplica al reparto por filas" << std::endl;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Formas de cargar la imagen de entrada
+enum LoadMode {
+    LOAD_ROOT = 0,      // El proceso 0 carga la imagen y la reparte con MPI_Scatterv
+    LOAD_MPIIO = 1,     // P5/P6: cada proceso lee sus filas con MPI-IO
+    LOAD_ASCII = 2      // P2/P3: cada proceso decodifica su parte del texto
+};
+
+// Carga completa en el proceso 0; aborta si falla
+Image* loadOnRoot(const std::string& inputFilename, int ioThreads) {
+    Image* image = ImageFactory::createImage(inputFilename, ioThreads);
+    if (image == nullptr) {
+        std::cerr << "Error: No se pudo cargar la imagen " << inputFilename << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return image;
 }
 
 void measureAndApplyFilterMPI(const std::string& inputFilename, const std::string& outputFilename, 
-                             const char* filterName, int rank, int size) {
+                             const char* filterName, const Options& options, int rank, int size) {
     if (rank == 0) {
         std::cout << "\n========================================" << std::endl;
         std::cout << "Filtrador Distribuido con MPI" << std::endl;
@@ -33,59 +155,128 @@ void measureAndApplyFilterMPI(const std::string& inputFilename, const std::strin
     }
     
     Image* image = nullptr;
-    auto loadTime = std::chrono::microseconds(0);
+    ImageHeader header;
+    int loadMode = LOAD_ROOT;
+    auto startLoad = std::chrono::high_resolution_clock::now();
     
-    // Solo el proceso 0 carga la imagen
+    // Cada proceso lee su parte de las entradas P5/P6 (MPI-IO) y P2/P3
+    // (decodificación distribuida); los archivos inválidos los carga el
+    // proceso 0 para informar del error. Con el reparto 2D y con memoria
+    // compartida la imagen siempre la carga el proceso 0
+    bool rowBlocks = !options.blocks2D && !options.sharedMemory;
     if (rank == 0) {
-        auto startLoad = std::chrono::high_resolution_clock::now();
-        image = ImageFactory::createImage(inputFilename);
-        auto endLoad = std::chrono::high_resolution_clock::now();
-        
-        if (image == nullptr) {
-            std::cerr << "Error: No se pudo cargar la imagen " << inputFilename << std::endl;
-            MPI_Abort(MPI_COMM_WORLD, 1);
+        if (rowBlocks && MPIFilter::probeBinaryImage(inputFilename, header)) {
+            loadMode = LOAD_MPIIO;
+        } else if (rowBlocks && MPIFilter::probeAsciiImage(inputFilename, header)) {
+            loadMode = LOAD_ASCII;
+        } else {
+            image = loadOnRoot(inputFilename, options.ioThreads);
+            header.magicNumber = image->getMagicNumber();
+            header.width = image->getWidth();
+            header.height = image->getHeight();
+            header.maxVal = image->getMaxVal();
         }
-        
-        loadTime = std::chrono::duration_cast<std::chrono::microseconds>(endLoad - startLoad);
-        std::cout << "Tiempo de carga: " << loadTime.count() << " microsegundos" << std::endl;
-        
-        // Mostrar información de la imagen
-        image->displayInfo();
     }
     
     // Broadcast información básica de la imagen a todos los procesos
-    int width, height, maxVal;
-    char magicNumberArray[10];
+    int dimensions[4] = { header.width, header.height, header.maxVal, loadMode };
+    long long dataOffset = (long long)header.dataOffset;
+    char magicNumberArray[10] = {};
     
     if (rank == 0) {
-        width = image->getWidth();
-        height = image->getHeight();
-        maxVal = image->getMaxVal();
-        strncpy(magicNumberArray, image->getMagicNumber().c_str(), sizeof(magicNumberArray));
+        strncpy(magicNumberArray, header.magicNumber.c_str(), sizeof(magicNumberArray) - 1);
     }
     
-    MPI_Bcast(&width, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&height, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&maxVal, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(dimensions, 4, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&dataOffset, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
     MPI_Bcast(magicNumberArray, sizeof(magicNumberArray), MPI_CHAR, 0, MPI_COMM_WORLD);
+    int width = dimensions[0];
+    int height = dimensions[1];
+    int maxVal = dimensions[2];
+    loadMode = dimensions[3];
+    std::string magicNumber(magicNumberArray);
+    
+    // Malla cartesiana de procesos para el reparto 2D
+    BlockDecomposition* blocks = options.blocks2D ? new BlockDecomposition(width, height, size) : nullptr;
+    MPI_Comm grid = blocks ? MPIFilter::createGrid(*blocks) : MPI_COMM_NULL;
+    // Ventana compartida de cada nodo
+    NodeWindow* node = options.sharedMemory ? new NodeWindow(width, height, maxVal, magicNumber) : nullptr;
     
-    // Los demás procesos crean una imagen vacía con las dimensiones correctas
-    if (rank != 0) {
-        std::string magicNumber(magicNumberArray);
-        if (magicNumber == "P2") {
-            image = new PGMImage(width, height, maxVal);
-        } else if (magicNumber == "P3") {
-            image = new PPMImage(width, height, maxVal);
+    Image* localBlock = nullptr;
+    auto loadTime = std::chrono::microseconds(0);
+    auto distributeTime = std::chrono::microseconds(0);
+    
+    if (loadMode != LOAD_ROOT) {
+        // Cada proceso lee su bloque de filas directamente del archivo
+        header.magicNumber = magicNumber;
+        header.width = width;
+        header.height = height;
+        header.maxVal = maxVal;
+        header.dataOffset = (size_t)dataOffset;
+        if (loadMode == LOAD_MPIIO) {
+            localBlock = MPIFilter::readImageParallel(inputFilename, header, rank, size);
+        } else {
+            localBlock = MPIFilter::readAsciiParallel(inputFilename, header, rank, size);
+            if (localBlock == nullptr) {
+                // Muestras ausentes o inválidas: el proceso 0 informa del error
+                loadMode = LOAD_ROOT;
+            }
+        }
+    }
+    
+    if (loadMode != LOAD_ROOT) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto endLoad = std::chrono::high_resolution_clock::now();
+        loadTime = std::chrono::duration_cast<std::chrono::microseconds>(endLoad - startLoad);
+        
+        if (rank == 0) {
+            std::cout << (loadMode == LOAD_MPIIO ? "Lectura paralela con MPI-IO ("
+                                                 : "Decodificación ASCII distribuida (")
+                      << size << " procesos)" << std::endl;
+            std::cout << "Tiempo de carga: " << loadTime.count() << " microsegundos" << std::endl;
+            std::cout << "Información de la imagen:" << std::endl;
+            std::cout << "Número mágico: " << magicNumber << std::endl;
+            std::cout << "Dimensiones: " << width << " x " << height << std::endl;
+            std::cout << "Valor máximo: " << maxVal << std::endl;
+        }
+    } else {
+        if (rank == 0) {
+            if (image == nullptr) {
+                image = loadOnRoot(inputFilename, options.ioThreads);
+            }
+            auto endLoad = std::chrono::high_resolution_clock::now();
+            loadTime = std::chrono::duration_cast<std::chrono::microseconds>(endLoad - startLoad);
+            std::cout << "Tiempo de carga: " << loadTime.count() << " microsegundos" << std::endl;
+            
+            // Mostrar información de la imagen
+            image->displayInfo();
         }
         
-        if (image == nullptr) {
-            std::cerr << "Proceso " << rank << ": Error creando imagen" << std::endl;
-            MPI_Abort(MPI_COMM_WORLD, 1);
+        // Repartir bloques de filas: cada proceso recibe solo las suyas
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto startDistribute = std::chrono::high_resolution_clock::now();
+        
+        if (options.blocks2D) {
+            localBlock = MPIFilter::distributeBlocks(image, maxVal, magicNumber, *blocks, grid);
+        } else if (options.sharedMemory) {
+            localBlock = MPIFilter::distributeShared(image, width, maxVal, magicNumber, *node);
+        } else {
+            localBlock = MPIFilter::distributeImage(image, width, height, maxVal, magicNumber, rank, size);
+        }
+        
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto endDistribute = std::chrono::high_resolution_clock::now();
+        
+        distributeTime = std::chrono::duration_cast<std::chrono::microseconds>(endDistribute - startDistribute);
+        if (rank == 0) {
+            std::cout << "Tiempo de distribución: " << distributeTime.count() << " microsegundos" << std::endl;
         }
     }
     
-    // TODO: En una implementación completa, aquí se distribuirían los datos de píxeles
-    // Por simplicidad, asumimos que todos los procesos tienen acceso a la imagen completa
+    if (localBlock == nullptr) {
+        std::cerr << "Proceso " << rank << ": Error creando el bloque local" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
     
     // Crear filtro
     Filter* filter = FilterFactory::createFilter(filterName);
@@ -93,19 +284,49 @@ void measureAndApplyFilterMPI(const std::string& inputFilename, const std::strin
         if (rank == 0) {
             std::cerr << "Error: Filtro no reconocido: " << filterName << std::endl;
         }
+        delete localBlock;
         delete image;
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
     
     if (rank == 0) {
-        std::cout << "Aplicando filtro: " << filter->getName() << " con MPI" << std::endl;
+        std::cout << "Aplicando filtro: " << filter->getName() << " con MPI"
+                  << (options.overlap && rowBlocks ? " (comunicación solapada)" : "") << std::endl;
+        if (options.blocks2D) {
+            std::cout << "Reparto 2D por bloques: malla de " << blocks->dims[0] << " x " << blocks->dims[1]
+                      << " procesos" << std::endl;
+        }
+        if (options.sharedMemory) {
+            std::cout << "Memoria compartida por nodo: MPI_Win_allocate_shared" << std::endl;
+        }
+        if (options.overlap && !rowBlocks) {
+            std::cerr << "Advertencia: --overlap solo se aplica al reparto por filas" << std::endl;
+        }
+        std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
+        if (MPIFilter::getThreads() > 1) {
+            std::cout << "Modo híbrido MPI + OpenMP: " << MPIFilter::getThreads()
+                      << " hilos en el proceso 0" << std::endl;
+        }
+        if (options.iterations > 1) {
+            std::cout << "Iteraciones: " << options.iterations
+                      << " (doble buffer y solicitudes persistentes)" << std::endl;
+        }
     }
     
     // Medir tiempo de aplicación del filtro con MPI
     MPI_Barrier(MPI_COMM_WORLD);
     auto startFilter = std::chrono::high_resolution_clock::now();
     
-    Image* filteredImage = MPIFilter::applyFilterDistributed(image, filter, rank, size);
+    MPIFilter::setOverlap(options.overlap);
+    MPIFilter::setIterations(options.iterations);
+    Image* filteredImage = nullptr;
+    if (options.blocks2D) {
+        filteredImage = MPIFilter::applyFilterBlocks(localBlock, filter, *blocks, grid);
+    } else if (options.sharedMemory) {
+        filteredImage = MPIFilter::applyFilterShared(localBlock, filter, *node);
+    } else {
+        filteredImage = MPIFilter::applyFilterDistributed(localBlock, filter, height, rank, size);
+    }
     
     MPI_Barrier(MPI_COMM_WORLD);
     auto endFilter = std::chrono::high_resolution_clock::now();
@@ -115,6 +336,7 @@ void measureAndApplyFilterMPI(const std::string& inputFilename, const std::strin
             std::cerr << "Error: No se pudo aplicar el filtro con MPI" << std::endl;
         }
         delete filter;
+        delete localBlock;
         delete image;
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
@@ -123,25 +345,65 @@ void measureAndApplyFilterMPI(const std::string& inputFilename, const std::strin
     
     if (rank == 0) {
         std::cout << "Tiempo de aplicación del filtro (MPI): " << filterTime.count() << " microsegundos" << std::endl;
+        if (options.iterations > 1) {
+            std::cout << "Tiempo por iteración: " << filterTime.count() / options.iterations
+                      << " microsegundos" << std::endl;
+        }
     }
     
-    // Recopilar resultados de todos los procesos
-    Image* completeImage = MPIFilter::gatherImage(filteredImage, image->getWidth(), 
-                                                 image->getHeight(), image->getMaxVal(),
-                                                 image->getMagicNumber(), rank, size);
+    // Codificación de salida: la solicitada o la de la imagen de entrada
+    bool inputBinary = magicNumber == "P5" || magicNumber == "P6";
+    bool outputBinary = options.outputBinary < 0 ? inputBinary : options.outputBinary == 1;
     
-    // Solo el proceso 0 guarda el resultado
+    Image* completeImage = nullptr;
+    auto gatherTime = std::chrono::microseconds(0);
     auto saveTime = std::chrono::microseconds(0);
-    if (rank == 0) {
+    bool success = false;
+    
+    if (outputBinary && rowBlocks) {
+        // Cada proceso escribe sus filas directamente en el archivo
+        filteredImage->setBinary(true);
         auto startSave = std::chrono::high_resolution_clock::now();
-        bool success = completeImage->writeToFile(outputFilename);
+        success = MPIFilter::writeImageParallel(outputFilename, filteredImage, height, rank, size);
         auto endSave = std::chrono::high_resolution_clock::now();
         
         saveTime = std::chrono::duration_cast<std::chrono::microseconds>(endSave - startSave);
-        std::cout << "Tiempo de guardado: " << saveTime.count() << " microsegundos" << std::endl;
+        if (rank == 0) {
+            std::cout << "Escritura paralela con MPI-IO (" << size << " procesos)" << std::endl;
+            std::cout << "Tiempo de guardado: " << saveTime.count() << " microsegundos" << std::endl;
+        }
+    } else {
+        // Recopilar resultados de todos los procesos
+        auto startGather = std::chrono::high_resolution_clock::now();
+        if (options.blocks2D) {
+            completeImage = MPIFilter::gatherBlocks(filteredImage, width, height, maxVal, magicNumber, *blocks, grid);
+        } else if (options.sharedMemory) {
+            completeImage = MPIFilter::gatherShared(filteredImage, width, height, maxVal, magicNumber, *node);
+        } else {
+            completeImage = MPIFilter::gatherImage(filteredImage, width, height, maxVal, magicNumber, rank, size);
+        }
+        auto endGather = std::chrono::high_resolution_clock::now();
         
+        gatherTime = std::chrono::duration_cast<std::chrono::microseconds>(endGather - startGather);
+        
+        // Solo el proceso 0 guarda el resultado
+        if (rank == 0) {
+            std::cout << "Tiempo de recopilación: " << gatherTime.count() << " microsegundos" << std::endl;
+            completeImage->setBinary(outputBinary);
+            completeImage->setIOThreads(options.ioThreads);
+            
+            auto startSave = std::chrono::high_resolution_clock::now();
+            success = completeImage->writeToFile(outputFilename);
+            auto endSave = std::chrono::high_resolution_clock::now();
+            
+            saveTime = std::chrono::duration_cast<std::chrono::microseconds>(endSave - startSave);
+            std::cout << "Tiempo de guardado: " << saveTime.count() << " microsegundos" << std::endl;
+        }
+    }
+    
+    if (rank == 0) {
         // Calcular tiempo total
-        auto totalTime = loadTime + filterTime + saveTime;
+        auto totalTime = loadTime + distributeTime + filterTime + gatherTime + saveTime;
         std::cout << "Tiempo total: " << totalTime.count() << " microsegundos" << std::endl;
         
         if (success) {
@@ -153,19 +415,245 @@ void measureAndApplyFilterMPI(const std::string& inputFilename, const std::strin
     
     // Limpiar memoria
     delete filteredImage;
+    delete localBlock;
     if (rank == 0 && completeImage) {
         delete completeImage;
     }
     delete filter;
     delete image;
+    if (grid != MPI_COMM_NULL) {
+        MPI_Comm_free(&grid);
+    }
+    delete blocks;
+    // Los bloques del modo compartido solo eran vistas sobre la ventana
+    delete node;
     
     if (rank == 0) {
         std::cout << "Procesamiento con MPI completado." << std::endl;
     }
 }
 
+// Modo por lotes: mensajes entre el proceso 0 y los trabajadores
+const int TAG_REQUEST = 10;   // Trabajador -> 0: resultado del trabajo anterior y petición del siguiente
+const int TAG_WORK = 11;      // 0 -> trabajador: ruta de la siguiente imagen
+const int TAG_STOP = 12;      // 0 -> trabajador: no quedan imágenes
+
+// Resultado que acompaña a cada petición
+enum BatchResult {
+    BATCH_NONE = -1,    // Primera petición, sin trabajo anterior
+    BATCH_FAILED = 0,
+    BATCH_DONE = 1
+};
+
+// Lee la lista de imágenes: una ruta por línea; se ignoran las líneas vacías
+// y las que empiezan por '#'
+bool readBatchList(const std::string& listFilename, std::vector<std::string>& inputs) {
+    std::ifstream list(listFilename.c_str());
+    if (!list.is_open()) {
+        std::cerr << "Error: No se pudo abrir la lista de imágenes " << listFilename << std::endl;
+        return false;
+    }
+    
+    std::string line;
+    while (std::getline(list, line)) {
+        size_t end = line.find_last_not_of(" \t\r");
+        if (end == std::string::npos || line[0] == '#') continue;
+        inputs.push_back(line.substr(0, end + 1));
+    }
+    return true;
+}
+
+// Salida de una imagen del lote: mismo nombre dentro del directorio de salida
+std::string batchOutputPath(const std::string& outputDir, const std::string& input) {
+    size_t slash = input.find_last_of('/');
+    return outputDir + "/" + (slash == std::string::npos ? input : input.substr(slash + 1));
+}
+
+// Ruta absoluta sin enlaces ni "..", o la ruta tal cual si no existe
+std::string resolvePath(const std::string& path) {
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+}
+
+// Rechaza las listas en las que una salida sobrescribiría una entrada (el
+// directorio de salida es el de la imagen) o la salida de otra imagen (dos
+// entradas con el mismo nombre de archivo)
+bool checkBatchOutputs(const std::vector<std::string>& inputs, const std::string& outputDir) {
+    char resolved[PATH_MAX];
+    if (realpath(outputDir.c_str(), resolved) == nullptr) {
+        std::cerr << "Error: No existe el directorio de salida " << outputDir << std::endl;
+        return false;
+    }
+    std::string resolvedDir(resolved);
+    
+    std::set<std::string> names;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        std::string output = batchOutputPath(resolvedDir, inputs[i]);
+        std::string name = output.substr(resolvedDir.size() + 1);
+        if (resolvePath(output) == resolvePath(inputs[i])) {
+            std::cerr << "Error: La salida de " << inputs[i] << " sobrescribiría la propia entrada" << std::endl;
+            return false;
+        }
+        if (!names.insert(name).second) {
+            std::cerr << "Error: Dos imágenes del lote se llaman " << name
+                      << " y escribirían la misma salida" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Carga, filtra y guarda una imagen del lote en el proceso que la recibe
+bool processBatchImage(const std::string& input, const std::string& outputDir, Filter* filter,
+                       const Options& options, int rank) {
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    Image* image = ImageFactory::createImage(input, options.ioThreads);
+    if (image == nullptr) {
+        std::cerr << "Proceso " << rank << ": Error: No se pudo cargar la imagen " << input << std::endl;
+        return false;
+    }
+    
+    Image* filtered = MPIFilter::filterImage(image, filter);
+    bool success = false;
+    std::string output = batchOutputPath(outputDir, input);
+    if (filtered != nullptr) {
+        bool binary = options.outputBinary < 0 ? image->isBinary() : options.outputBinary == 1;
+        filtered->setBinary(binary);
+        filtered->setIOThreads(options.ioThreads);
+        success = filtered->writeToFile(output);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    if (success) {
+        std::cout << "Proceso " << rank << ": " << input << " -> " << output << " ("
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                  << " microsegundos)" << std::endl;
+    } else {
+        std::cerr << "Proceso " << rank << ": Error al filtrar o guardar " << input << std::endl;
+    }
+    
+    delete filtered;
+    delete image;
+    return success;
+}
+
+// Proceso 0: entrega la siguiente ruta a cada trabajador que la pide, así
+// las imágenes grandes no retrasan al resto. Cuenta los resultados
+void runBatchMaster(const std::vector<std::string>& inputs, int size, int& done, int& failed) {
+    size_t next = 0;
+    int active = size - 1;
+    while (active > 0) {
+        int result;
+        MPI_Status status;
+        MPI_Recv(&result, 1, MPI_INT, MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &status);
+        if (result == BATCH_DONE) done++;
+        if (result == BATCH_FAILED) failed++;
+        
+        if (next < inputs.size()) {
+            const std::string& path = inputs[next++];
+            MPI_Send(path.c_str(), (int)path.size(), MPI_CHAR, status.MPI_SOURCE, TAG_WORK, MPI_COMM_WORLD);
+        } else {
+            MPI_Send(nullptr, 0, MPI_CHAR, status.MPI_SOURCE, TAG_STOP, MPI_COMM_WORLD);
+            active--;
+        }
+    }
+}
+
+// Trabajador: pide imágenes hasta que el proceso 0 indica que no quedan
+void runBatchWorker(const std::string& outputDir, Filter* filter, const Options& options, int rank) {
+    int result = BATCH_NONE;
+    while (true) {
+        MPI_Send(&result, 1, MPI_INT, 0, TAG_REQUEST, MPI_COMM_WORLD);
+        
+        MPI_Status status;
+        MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        int length;
+        MPI_Get_count(&status, MPI_CHAR, &length);
+        std::vector<char> path(length + 1, '\0');
+        MPI_Recv(path.data(), length, MPI_CHAR, 0, status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (status.MPI_TAG == TAG_STOP) break;
+        
+        result = processBatchImage(path.data(), outputDir, filter, options, rank) ? BATCH_DONE : BATCH_FAILED;
+    }
+}
+
+// Devuelve, en todos los procesos, cuántas imágenes fallaron (-1 si el lote
+// no se pudo empezar)
+int measureBatchMPI(const std::string& listFilename, const std::string& outputDir, const char* filterName,
+                    const Options& options, int rank, int size) {
+    // Solo el proceso 0 lee y valida la lista; -1 indica que no se puede procesar
+    std::vector<std::string> inputs;
+    int count = 0;
+    if (rank == 0) {
+        bool valid = readBatchList(listFilename, inputs) && checkBatchOutputs(inputs, outputDir);
+        count = valid ? (int)inputs.size() : -1;
+    }
+    MPI_Bcast(&count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (count < 0) return -1;
+    
+    Filter* filter = FilterFactory::createFilter(filterName);
+    if (filter == nullptr) {
+        if (rank == 0) {
+            std::cerr << "Error: Filtro no reconocido: " << filterName << std::endl;
+        }
+        return -1;
+    }
+    
+    if (rank == 0) {
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "Filtrador Distribuido con MPI - Modo por lotes" << std::endl;
+        std::cout << "Lista de imágenes: " << listFilename << " (" << count << " imágenes)" << std::endl;
+        std::cout << "Filtro: " << filter->getName() << std::endl;
+        std::cout << "Directorio de salida: " << outputDir << std::endl;
+        std::cout << "Trabajadores: " << (size > 1 ? size - 1 : 1) << std::endl;
+        std::cout << "========================================" << std::endl;
+    }
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    int done = 0;
+    int failed = 0;
+    if (size == 1) {
+        // Sin trabajadores: el proceso 0 procesa la lista él mismo
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (processBatchImage(inputs[i], outputDir, filter, options, rank)) {
+                done++;
+            } else {
+                failed++;
+            }
+        }
+    } else if (rank == 0) {
+        runBatchMaster(inputs, size, done, failed);
+    } else {
+        runBatchWorker(outputDir, filter, options, rank);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    
+    if (rank == 0) {
+        std::cout << "Imágenes filtradas: " << done << " de " << count;
+        if (failed > 0) std::cout << " (" << failed << " con errores)";
+        std::cout << std::endl;
+        std::cout << "Tiempo total del lote: " << totalTime.count() << " microsegundos" << std::endl;
+        if (totalTime.count() > 0) {
+            std::cout << "Rendimiento: " << done * 1000000.0 / totalTime.count() << " imágenes/s" << std::endl;
+        }
+    }
+    
+    // Solo el proceso 0 lleva la cuenta
+    MPI_Bcast(&failed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    delete filter;
+    return failed;
+}
+
 int main(int argc, char* argv[]) {
-    MPI_Init(&argc, &argv);
+    // Solo el hilo principal llama a MPI; los hilos de OpenMP del modo
+    // híbrido solo filtran
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -176,7 +664,7 @@ int main(int argc, char* argv[]) {
         std::cout << "Programación Paralela - Parcial 1" << std::endl;
     }
     
-    if (argc != 5) {
+    if (argc < 5) {
         if (rank == 0) {
             std::cerr << "Error: Número incorrecto de argumentos" << std::endl;
             printUsage(argv[0]);
@@ -199,11 +687,31 @@ int main(int argc, char* argv[]) {
     std::string outputFilename = argv[2];
     const char* filterName = argv[4];
     
+    Options options;
+    if (!parseOptions(argc, argv, options, rank)) {
+        if (rank == 0) {
+            printUsage(argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    if (options.threads != 1 && provided < MPI_THREAD_FUNNELED && rank == 0) {
+        std::cerr << "Advertencia: La biblioteca MPI no garantiza MPI_THREAD_FUNNELED" << std::endl;
+    }
+    MPIFilter::setThreads(options.threads);
+    
     // Medir tiempo total de CPU y de pared
     auto cpuStartTime = std::clock();
     auto wallStartTime = std::chrono::high_resolution_clock::now();
     
-    measureAndApplyFilterMPI(inputFilename, outputFilename, filterName, rank, size);
+    // En modo por lotes el código de salida es 1 si alguna imagen falló
+    int exitCode = 0;
+    if (options.batch) {
+        exitCode = measureBatchMPI(inputFilename, outputFilename, filterName, options, rank, size) != 0 ? 1 : 0;
+    } else {
+        measureAndApplyFilterMPI(inputFilename, outputFilename, filterName, options, rank, size);
+    }
     
     auto cpuEndTime = std::clock();
     auto wallEndTime = std::chrono::high_resolution_clock::now();
@@ -220,5 +728,5 @@ int main(int argc, char* argv[]) {
     }
     
     MPI_Finalize();
-    return 0;
+    return exitCode;
 }
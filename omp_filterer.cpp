@@ -2,25 +2,161 @@
 #include "PGMImage.h"
 #include "PPMImage.h"
 #include "Filter.h"
+#include "Convolution.h"
 #include "OMPFilter.h"
 #include <iostream>
 #include <chrono>
 #include <cstring>
+#include <cstdlib>
 #include <omp.h>
 
 void printUsage(const char* programName) {
-    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro>" << std::endl;
+    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro> [opciones]" << std::endl;
     std::cout << "Ejemplo: " << programName << " sulfur.pgm sulfur_blur.pgm --f blur" << std::endl;
     std::cout << "\nFormatos soportados:" << std::endl;
-    std::cout << "  - PPM (P3): Imágenes a color" << std::endl;
-    std::cout << "  - PGM (P2): Imágenes en escala de grises" << std::endl;
+    std::cout << "  - PPM (P3/P6): Imágenes a color (ASCII/binario)" << std::endl;
+    std::cout << "  - PGM (P2/P5): Imágenes en escala de grises (ASCII/binario)" << std::endl;
     std::cout << "\nFiltros disponibles:" << std::endl;
     std::cout << "  - blur: Filtro de suavizado" << std::endl;
     std::cout << "  - laplace/laplacian: Filtro Laplaciano (detección de bordes)" << std::endl;
     std::cout << "  - sharpen/sharpening: Filtro de realce" << std::endl;
+    std::cout << "\nOpciones:" << std::endl;
+    std::cout << "  --binary: Guardar la salida en binario (P5/P6)" << std::endl;
+    std::cout << "  --ascii: Guardar la salida en ASCII (P2/P3)" << std::endl;
+    std::cout << "  (por defecto se conserva la codificación del archivo de entrada)" << std::endl;
+    std::cout << "  --io-threads <n>: Hilos para decodificar y formatear archivos ASCII grandes (por defecto 1)" << std::endl;
+    std::cout << "  --stream: Filtrar por bandas de filas con memoria acotada (imágenes muy grandes)" << std::endl;
+    std::cout << "  (--stream lee y escribe de forma secuencial; no admite --io-threads)" << std::endl;
+    std::cout << "  --schedule <tipo>: Planificación de los bloques: static, dynamic, guided o auto" << std::endl;
+    std::cout << "  (por defecto la de OMP_SCHEDULE o la de la implementación)" << std::endl;
+    std::cout << "  --chunk <n>: Bloques entregados a la vez a cada hilo" << std::endl;
+    std::cout << "  --tile <n>: Lado de las teselas en píxeles (por defecto, según el tamaño de la caché L2)" << std::endl;
+    std::cout << "  --bands: Repartir bandas de filas de ancho completo en lugar de teselas" << std::endl;
+    std::cout << "  (con --tile <n>, bandas de n filas)" << std::endl;
 }
 
-void measureAndApplyFilterOMP(const std::string& inputFilename, const std::string& outputFilename, const char* filterName) {
+// Opciones de línea de comandos posteriores a "--f <filtro>"
+struct Options {
+    int outputBinary;   // 1: P5/P6, 0: P2/P3, -1: misma codificación que la entrada
+    int ioThreads;      // Hilos para decodificar y formatear archivos ASCII
+    bool stream;        // Modo streaming (ventana deslizante de filas)
+    bool setSchedule;   // Se pidió una planificación con --schedule o --chunk
+    omp_sched_t schedule;
+    int chunk;          // 0: tamaño de bloque por defecto de la planificación
+    int tileSize;       // Lado de las teselas o filas de las bandas (0: automático)
+    bool bands;         // Bandas de filas de ancho completo en lugar de teselas
+    
+    Options() : outputBinary(-1), ioThreads(1), stream(false), setSchedule(false),
+                schedule(omp_sched_dynamic), chunk(0), tileSize(0), bands(false) {}
+};
+
+bool parseSchedule(const char* name, omp_sched_t& kind) {
+    if (strcmp(name, "static") == 0) kind = omp_sched_static;
+    else if (strcmp(name, "dynamic") == 0) kind = omp_sched_dynamic;
+    else if (strcmp(name, "guided") == 0) kind = omp_sched_guided;
+    else if (strcmp(name, "auto") == 0) kind = omp_sched_auto;
+    else return false;
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            options.outputBinary = 1;
+        } else if (strcmp(argv[i], "--ascii") == 0) {
+            options.outputBinary = 0;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            options.stream = true;
+        } else if (strcmp(argv[i], "--bands") == 0) {
+            options.bands = true;
+        } else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc) {
+            if (!parseSchedule(argv[++i], options.schedule)) {
+                std::cerr << "Error: Planificación no reconocida: " << argv[i] << std::endl;
+                return false;
+            }
+            options.setSchedule = true;
+        } else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            options.chunk = atoi(argv[++i]);
+            if (options.chunk < 1) {
+                std::cerr << "Error: Tamaño de bloque inválido: " << argv[i] << std::endl;
+                return false;
+            }
+            if (!options.setSchedule) {
+                // Conservar el tipo vigente (OMP_SCHEDULE) si no se indicó otro
+                int currentChunk;
+                omp_get_schedule(&options.schedule, &currentChunk);
+            }
+            options.setSchedule = true;
+        } else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) {
+            options.tileSize = atoi(argv[++i]);
+            if (options.tileSize < 1) {
+                std::cerr << "Error: Tamaño de tesela inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc) {
+            options.ioThreads = atoi(argv[++i]);
+            if (options.ioThreads < 1) {
+                std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Opción no reconocida: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    // El modo streaming lee y escribe fila a fila de forma secuencial
+    if (options.stream && options.ioThreads > 1) {
+        std::cerr << "Error: --io-threads no se combina con --stream" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Modo streaming: lectura, filtrado y escritura por bandas de filas sin
+// cargar la imagen completa
+void measureAndApplyFilterOMPStreaming(const std::string& inputFilename, const std::string& outputFilename, const char* filterName, const Options& options) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Filtrador Paralelo con OpenMP" << std::endl;
+    std::cout << "Procesando archivo: " << inputFilename << std::endl;
+    std::cout << "Filtro: " << filterName << std::endl;
+    std::cout << "Archivo de salida: " << outputFilename << std::endl;
+    std::cout << "Modo: streaming" << std::endl;
+    std::cout << "Hilos disponibles: " << omp_get_max_threads() << std::endl;
+    std::cout << "========================================" << std::endl;
+    
+    // El kernel se obtiene del filtro, igual que en el modo normal
+    Filter* filter = FilterFactory::createFilter(filterName);
+    Kernel3x3 kernel;
+    if (filter == nullptr || !getFilterKernel(filter->getName(), kernel)) {
+        std::cerr << "Error: Filtro no reconocido: " << filterName << std::endl;
+        delete filter;
+        return;
+    }
+    
+    std::cout << "Aplicando filtro: " << filter->getName() << std::endl;
+    std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
+    
+    OMPStreamFilter streamFilter(kernel);
+    auto start = std::chrono::high_resolution_clock::now();
+    bool success = streamFilter.run(inputFilename, outputFilename, options.outputBinary);
+    auto end = std::chrono::high_resolution_clock::now();
+    
+    auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::cout << "Tiempo total: " << totalTime.count() << " microsegundos" << std::endl;
+    
+    if (success) {
+        const ImageHeader& header = streamFilter.getHeader();
+        std::cout << "Dimensiones: " << header.width << " x " << header.height << std::endl;
+        std::cout << "Imagen filtrada guardada exitosamente en: " << outputFilename << std::endl;
+    } else {
+        std::cerr << "Error al procesar la imagen en modo streaming" << std::endl;
+    }
+    
+    delete filter;
+    std::cout << "Procesamiento completado." << std::endl;
+}
+
+void measureAndApplyFilterOMP(const std::string& inputFilename, const std::string& outputFilename, const char* filterName, const Options& options) {
     std::cout << "\n========================================" << std::endl;
     std::cout << "Filtrador Paralelo con OpenMP" << std::endl;
     std::cout << "Procesando archivo: " << inputFilename << std::endl;
@@ -31,7 +167,7 @@ void measureAndApplyFilterOMP(const std::string& inputFilename, const std::strin
     
     // Medir tiempo de carga
     auto startLoad = std::chrono::high_resolution_clock::now();
-    Image* image = ImageFactory::createImage(inputFilename);
+    Image* image = ImageFactory::createImage(inputFilename, options.ioThreads);
     auto endLoad = std::chrono::high_resolution_clock::now();
     
     if (image == nullptr) {
@@ -54,6 +190,7 @@ void measureAndApplyFilterOMP(const std::string& inputFilename, const std::strin
     }
     
     std::cout << "Aplicando filtro: " << filter->getName() << " con OpenMP" << std::endl;
+    std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
     
     // Medir tiempo de aplicación del filtro con OpenMP
     auto startFilter = std::chrono::high_resolution_clock::now();
@@ -70,6 +207,10 @@ void measureAndApplyFilterOMP(const std::string& inputFilename, const std::strin
     auto filterTime = std::chrono::duration_cast<std::chrono::microseconds>(endFilter - startFilter);
     std::cout << "Tiempo de aplicación del filtro (OpenMP): " << filterTime.count() << " microsegundos" << std::endl;
     
+    // Codificación de salida: la solicitada o la de la imagen de entrada
+    filteredImage->setBinary(options.outputBinary < 0 ? image->isBinary() : options.outputBinary == 1);
+    filteredImage->setIOThreads(options.ioThreads);
+    
     // Medir tiempo de guardado
     auto startSave = std::chrono::high_resolution_clock::now();
     bool success = filteredImage->writeToFile(outputFilename);
@@ -99,7 +240,7 @@ int main(int argc, char* argv[]) {
     std::cout << "=== Filtrador de Imágenes PPM/PGM - Versión Paralela con OpenMP ===" << std::endl;
     std::cout << "Programación Paralela - Parcial 1" << std::endl;
     
-    if (argc != 5) {
+    if (argc < 5) {
         std::cerr << "Error: Número incorrecto de argumentos" << std::endl;
         printUsage(argv[0]);
         return 1;
@@ -116,11 +257,26 @@ int main(int argc, char* argv[]) {
     std::string outputFilename = argv[2];
     const char* filterName = argv[4];
     
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (options.setSchedule) {
+        omp_set_schedule(options.schedule, options.chunk);
+    }
+    OMPFilter::setTiling(options.tileSize, options.bands);
+    
     // Medir tiempo total de CPU y de pared
     auto cpuStartTime = std::clock();
     auto wallStartTime = std::chrono::high_resolution_clock::now();
     
-    measureAndApplyFilterOMP(inputFilename, outputFilename, filterName);
+    if (options.stream) {
+        measureAndApplyFilterOMPStreaming(inputFilename, outputFilename, filterName, options);
+    } else {
+        measureAndApplyFilterOMP(inputFilename, outputFilename, filterName, options);
+    }
     
     auto cpuEndTime = std::clock();
     auto wallEndTime = std::chrono::high_resolution_clock::now();
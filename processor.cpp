@@ -9,8 +9,8 @@ void printUsage(const char* programName) {
     std::cout << "Uso: " << programName << " <archivo_entrada1> [archivo_entrada2] ..." << std::endl;
     std::cout << "Ejemplo: " << programName << " lena.ppm fruit.pgm" << std::endl;
     std::cout << "\nFormatos soportados:" << std::endl;
-    std::cout << "  - PPM (P3): Imágenes a color" << std::endl;
-    std::cout << "  - PGM (P2): Imágenes en escala de grises" << std::endl;
+    std::cout << "  - PPM (P3/P6): Imágenes a color (ASCII/binario)" << std::endl;
+    std::cout << "  - PGM (P2/P5): Imágenes en escala de grises (ASCII/binario)" << std::endl;
 }
 
 void processImage(const std::string& filename) {
@@ -18,11 +18,7 @@ void processImage(const std::string& filename) {
     std::cout << "Procesando archivo: " << filename << std::endl;
     std::cout << "========================================" << std::endl;
     
-    // Determinar tipo de imagen
-    std::string imageType = ImageFactory::getImageType(filename);
-    std::cout << "Tipo de imagen detectado: " << imageType << std::endl;
-    
-    // Crear imagen usando el factory
+    // Crear imagen usando el factory (una sola apertura del archivo)
     auto start = std::chrono::high_resolution_clock::now();
     Image* image = ImageFactory::createImage(filename);
     auto end = std::chrono::high_resolution_clock::now();
@@ -32,6 +28,10 @@ void processImage(const std::string& filename) {
         return;
     }
     
+    // Determinar tipo de imagen a partir de la imagen cargada
+    std::string imageType = ImageFactory::getImageType(image);
+    std::cout << "Tipo de imagen detectado: " << imageType << std::endl;
+    
     auto loadTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     std::cout << "Tiempo de carga: " << loadTime.count() << " microsegundos" << std::endl;
     
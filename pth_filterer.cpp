@@ -2,24 +2,75 @@
 #include "PGMImage.h"
 #include "PPMImage.h"
 #include "Filter.h"
+#include "Convolution.h"
 #include "PthreadFilter.h"
 #include <iostream>
 #include <chrono>
 #include <cstring>
+#include <cstdlib>
 
 void printUsage(const char* programName) {
-    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro>" << std::endl;
+    std::cout << "Uso: " << programName << " <archivo_entrada> <archivo_salida> --f <filtro> [opciones]" << std::endl;
     std::cout << "Ejemplo: " << programName << " fruit.pgm fruit_blur2.pgm --f blur" << std::endl;
     std::cout << "\nFormatos soportados:" << std::endl;
-    std::cout << "  - PPM (P3): Imágenes a color" << std::endl;
-    std::cout << "  - PGM (P2): Imágenes en escala de grises" << std::endl;
+    std::cout << "  - PPM (P3/P6): Imágenes a color (ASCII/binario)" << std::endl;
+    std::cout << "  - PGM (P2/P5): Imágenes en escala de grises (ASCII/binario)" << std::endl;
     std::cout << "\nFiltros disponibles:" << std::endl;
     std::cout << "  - blur: Filtro de suavizado" << std::endl;
     std::cout << "  - laplace/laplacian: Filtro Laplaciano (detección de bordes)" << std::endl;
     std::cout << "  - sharpen/sharpening: Filtro de realce" << std::endl;
+    std::cout << "\nOpciones:" << std::endl;
+    std::cout << "  --binary: Guardar la salida en binario (P5/P6)" << std::endl;
+    std::cout << "  --ascii: Guardar la salida en ASCII (P2/P3)" << std::endl;
+    std::cout << "  (por defecto se conserva la codificación del archivo de entrada)" << std::endl;
+    std::cout << "  --io-threads <n>: Hilos para decodificar y formatear archivos ASCII grandes (por defecto 1)" << std::endl;
+    std::cout << "  --threads <n>: Hilos del pool de filtrado (por defecto, los hilos de la máquina)" << std::endl;
+    std::cout << "  --tile <n>: Lado de las teselas en píxeles (por defecto, según el tamaño de la caché L2)" << std::endl;
 }
 
-void measureAndApplyFilterPthread(const std::string& inputFilename, const std::string& outputFilename, const char* filterName) {
+// Opciones de línea de comandos posteriores a "--f <filtro>"
+struct Options {
+    int outputBinary;   // 1: P5/P6, 0: P2/P3, -1: misma codificación que la entrada
+    int ioThreads;      // Hilos para decodificar y formatear archivos ASCII
+    int threads;        // Hilos del pool de filtrado (0: hilos de la máquina)
+    int tileSize;       // Lado de las teselas (0: automático)
+    
+    Options() : outputBinary(-1), ioThreads(1), threads(0), tileSize(0) {}
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            options.outputBinary = 1;
+        } else if (strcmp(argv[i], "--ascii") == 0) {
+            options.outputBinary = 0;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+            if (options.threads < 1) {
+                std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) {
+            options.tileSize = atoi(argv[++i]);
+            if (options.tileSize < 1) {
+                std::cerr << "Error: Tamaño de tesela inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc) {
+            options.ioThreads = atoi(argv[++i]);
+            if (options.ioThreads < 1) {
+                std::cerr << "Error: Número de hilos inválido: " << argv[i] << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Opción no reconocida: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void measureAndApplyFilterPthread(const std::string& inputFilename, const std::string& outputFilename, const char* filterName, const Options& options) {
     std::cout << "\n========================================" << std::endl;
     std::cout << "Filtrador Paralelo con Pthreads" << std::endl;
     std::cout << "Procesando archivo: " << inputFilename << std::endl;
@@ -29,7 +80,7 @@ void measureAndApplyFilterPthread(const std::string& inputFilename, const std::s
     
     // Medir tiempo de carga
     auto startLoad = std::chrono::high_resolution_clock::now();
-    Image* image = ImageFactory::createImage(inputFilename);
+    Image* image = ImageFactory::createImage(inputFilename, options.ioThreads);
     auto endLoad = std::chrono::high_resolution_clock::now();
     
     if (image == nullptr) {
@@ -51,7 +102,9 @@ void measureAndApplyFilterPthread(const std::string& inputFilename, const std::s
         return;
     }
     
-    std::cout << "Aplicando filtro: " << filter->getName() << " con Pthreads (4 hilos)" << std::endl;
+    std::cout << "Aplicando filtro: " << filter->getName() << " con Pthreads ("
+              << PthreadFilter::getNumThreads() << " hilos)" << std::endl;
+    std::cout << "Instrucciones vectoriales: " << getSIMDLevelName() << std::endl;
     
     // Medir tiempo de aplicación del filtro con pthreads
     auto startFilter = std::chrono::high_resolution_clock::now();
@@ -68,6 +121,10 @@ void measureAndApplyFilterPthread(const std::string& inputFilename, const std::s
     auto filterTime = std::chrono::duration_cast<std::chrono::microseconds>(endFilter - startFilter);
     std::cout << "Tiempo de aplicación del filtro (Pthreads): " << filterTime.count() << " microsegundos" << std::endl;
     
+    // Codificación de salida: la solicitada o la de la imagen de entrada
+    filteredImage->setBinary(options.outputBinary < 0 ? image->isBinary() : options.outputBinary == 1);
+    filteredImage->setIOThreads(options.ioThreads);
+    
     // Medir tiempo de guardado
     auto startSave = std::chrono::high_resolution_clock::now();
     bool success = filteredImage->writeToFile(outputFilename);
@@ -97,7 +154,7 @@ int main(int argc, char* argv[]) {
     std::cout << "=== Filtrador de Imágenes PPM/PGM - Versión Paralela con Pthreads ===" << std::endl;
     std::cout << "Programación Paralela - Parcial 1" << std::endl;
     
-    if (argc != 5) {
+    if (argc < 5) {
         std::cerr << "Error: Número incorrecto de argumentos" << std::endl;
         printUsage(argv[0]);
         return 1;
@@ -114,11 +171,20 @@ int main(int argc, char* argv[]) {
     std::string outputFilename = argv[2];
     const char* filterName = argv[4];
     
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
     // Medir tiempo total de CPU y de pared
     auto cpuStartTime = std::clock();
     auto wallStartTime = std::chrono::high_resolution_clock::now();
     
-    measureAndApplyFilterPthread(inputFilename, outputFilename, filterName);
+    PthreadFilter::setNumThreads(options.threads);
+    PthreadFilter::setTileSize(options.tileSize);
+    measureAndApplyFilterPthread(inputFilename, outputFilename, filterName, options);
+    PthreadFilter::shutdown();
     
     auto cpuEndTime = std::clock();
     auto wallEndTime = std::chrono::high_resolution_clock::now();